@@ -0,0 +1,94 @@
+#ifndef TRACKERBOT_ASYNC_SQL_H
+#define TRACKERBOT_ASYNC_SQL_H
+
+#include "sql.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//Runs sql_handler work on dedicated worker threads, each holding its own pooled connection,
+//so callers on Discord event threads never wait on Postgres
+class Async_SQL {
+public:
+	using Error_Callback = std::function<void(std::exception_ptr)>;
+
+	Async_SQL(std::shared_ptr<sql_handler> sql, int worker_count);
+	~Async_SQL();
+
+	Async_SQL(const Async_SQL&) = delete;
+	Async_SQL& operator=(const Async_SQL&) = delete;
+	Async_SQL(Async_SQL&&) = delete;
+	Async_SQL& operator=(Async_SQL&&) = delete;
+
+	//Future variant - the job's result or exception is delivered through the returned future
+	template<typename Func>
+	auto submit(Func&& func) -> std::future<std::invoke_result_t<Func, sql_handler&>> {
+		using Result = std::invoke_result_t<Func, sql_handler&>;
+
+		auto task = std::make_shared<std::packaged_task<Result(sql_handler&)>>(std::forward<Func>(func));
+		std::future<Result> res = task->get_future();
+		enqueue([task](sql_handler& sql) { (*task)(sql); });
+
+		return res;
+	}
+	//Callback variant - on_complete runs on the worker thread; errors go to on_error, or the log if none is given
+	template<typename Func, typename Callback>
+	void post(Func&& func, Callback&& on_complete, Error_Callback on_error = nullptr) {
+		using Result = std::invoke_result_t<Func, sql_handler&>;
+
+		enqueue([func = std::forward<Func>(func), on_complete = std::forward<Callback>(on_complete), on_error = std::move(on_error)](sql_handler& sql) mutable {
+			try {
+				if constexpr(std::is_void_v<Result>) {
+					func(sql);
+					on_complete();
+				}
+				else {
+					on_complete(func(sql));
+				}
+			}
+			catch(...) {
+				report_error(on_error, std::current_exception());
+			}
+		});
+	}
+	//Fire and forget - failures are only logged
+	template<typename Func>
+	void post(Func&& func) {
+		enqueue([func = std::forward<Func>(func)](sql_handler& sql) mutable {
+			try {
+				func(sql);
+			}
+			catch(...) {
+				report_error(nullptr, std::current_exception());
+			}
+		});
+	}
+
+	std::size_t pending();
+
+private:
+	using Job = std::function<void(sql_handler&)>;
+
+	std::shared_ptr<sql_handler> _sql;
+
+	std::mutex _queue_mtx;
+	std::condition_variable _queue_cv;
+	std::deque<Job> _jobs;
+	bool _stopping = false;
+	std::vector<std::thread> _workers;
+
+	void enqueue(Job job);
+	void worker_loop();
+	static void report_error(const Error_Callback& on_error, std::exception_ptr error);
+};
+
+#endif // TRACKERBOT_ASYNC_SQL_H
\ No newline at end of file
@@ -0,0 +1,109 @@
+#ifndef TRACKERBOT_BOUNDED_QUEUE_H
+#define TRACKERBOT_BOUNDED_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+//Fixed-capacity multi-producer / multi-consumer queue between pipeline stages
+//push blocks while the queue is full, so a slow consumer throttles its producer instead of growing memory
+template<typename T>
+class Bounded_Queue {
+public:
+	explicit Bounded_Queue(std::size_t capacity)
+		: _capacity(capacity == 0 ? 1 : capacity)
+	{
+	}
+
+	Bounded_Queue(const Bounded_Queue&) = delete;
+	Bounded_Queue& operator=(const Bounded_Queue&) = delete;
+
+	//False if the queue was closed before there was room
+	bool push(T item) {
+		std::unique_lock<std::mutex> lock(_queue_mtx);
+		_not_full_cv.wait(lock, [this]() { return _closed || _items.size() < _capacity; });
+		if(_closed) {
+			return false;
+		}
+		_items.emplace_back(std::move(item));
+		lock.unlock();
+
+		_not_empty_cv.notify_one();
+		return true;
+	}
+	//Never blocks - false if the queue is full or closed
+	bool try_push(T item) {
+		{
+			std::lock_guard<std::mutex> lock(_queue_mtx);
+			if(_closed || _items.size() >= _capacity) {
+				return false;
+			}
+			_items.emplace_back(std::move(item));
+		}
+		_not_empty_cv.notify_one();
+		return true;
+	}
+
+	//Waits up to timeout for an item; nullopt on timeout or once closed & drained
+	template<typename Rep, typename Period>
+	std::optional<T> pop_for(std::chrono::duration<Rep, Period> timeout) {
+		std::unique_lock<std::mutex> lock(_queue_mtx);
+		if(!_not_empty_cv.wait_for(lock, timeout, [this]() { return _closed || !_items.empty(); }) || _items.empty()) {
+			return std::nullopt;
+		}
+		T item = std::move(_items.front());
+		_items.pop_front();
+		lock.unlock();
+
+		_not_full_cv.notify_one();
+		return item;
+	}
+	//Takes everything queued right now without waiting
+	std::vector<T> drain() {
+		std::vector<T> res;
+		{
+			std::lock_guard<std::mutex> lock(_queue_mtx);
+			res.reserve(_items.size());
+			for(auto& item : _items) {
+				res.emplace_back(std::move(item));
+			}
+			_items.clear();
+		}
+		_not_full_cv.notify_all();
+
+		return res;
+	}
+
+	//Wakes every waiter; pushes fail from here on, pops return what is left
+	void close() {
+		{
+			std::lock_guard<std::mutex> lock(_queue_mtx);
+			_closed = true;
+		}
+		_not_full_cv.notify_all();
+		_not_empty_cv.notify_all();
+	}
+	bool is_closed() {
+		std::lock_guard<std::mutex> lock(_queue_mtx);
+		return _closed;
+	}
+	std::size_t size() {
+		std::lock_guard<std::mutex> lock(_queue_mtx);
+		return _items.size();
+	}
+
+private:
+	std::mutex _queue_mtx;
+	std::condition_variable _not_full_cv;
+	std::condition_variable _not_empty_cv;
+	std::size_t _capacity;
+	std::deque<T> _items;
+	bool _closed = false;
+};
+
+#endif // TRACKERBOT_BOUNDED_QUEUE_H
\ No newline at end of file
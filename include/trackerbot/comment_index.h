@@ -0,0 +1,42 @@
+#ifndef TRACKERBOT_COMMENT_INDEX_H
+#define TRACKERBOT_COMMENT_INDEX_H
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+//In-memory record of stored comment IDs - a hash set of recent packed IDs, with a Bloom filter over the full history
+class Comment_Index {
+public:
+	enum class Lookup { SEEN, NOT_SEEN, UNKNOWN };
+
+	//Reddit IDs are base36 - anything up to 12 characters fits in 64 bits
+	static bool pack_id(const std::string& comment_id, uint64_t& packed);
+
+	//Clears & resizes the index; lookups stay UNKNOWN until mark_ready, so a partial warmup is never trusted
+	void reset(std::size_t expected_count);
+	void mark_ready();
+	void insert(const std::string& comment_id, bool recent = true);
+	void erase(const std::string& comment_id);
+	Lookup lookup(const std::string& comment_id);
+
+	std::size_t recent_size();
+
+private:
+	static constexpr int bloom_hash_count = 7;
+	static constexpr std::size_t bloom_bits_per_entry = 10;
+	static constexpr std::size_t bloom_min_bits = 1 << 20;
+
+	std::shared_mutex _index_mtx;
+	bool _ready = false;
+	std::unordered_set<uint64_t> _recent;
+	std::vector<uint64_t> _bloom;
+	std::size_t _bloom_bit_count = 0;
+
+	void bloom_insert(uint64_t packed);
+	bool bloom_contains(uint64_t packed) const;
+};
+
+#endif // TRACKERBOT_COMMENT_INDEX_H
@@ -0,0 +1,84 @@
+#ifndef TRACKERBOT_CONNECTION_POOL_H
+#define TRACKERBOT_CONNECTION_POOL_H
+
+#include <pqxx/pqxx>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Connection_Pool {
+public:
+	using Setup_Function = std::function<void(pqxx::connection&)>;
+
+	Connection_Pool(std::string conn_string, int pool_size, Setup_Function on_connect);
+
+	Connection_Pool(const Connection_Pool&) = delete;
+	Connection_Pool& operator=(const Connection_Pool&) = delete;
+	Connection_Pool(Connection_Pool&&) = delete;
+	Connection_Pool& operator=(Connection_Pool&&) = delete;
+
+	struct Stats {
+		int pool_size = 0;
+		int idle = 0;
+		uint64_t checkouts = 0;
+		uint64_t contended_checkouts = 0;
+		uint64_t reconnects = 0;
+		int64_t total_wait_us = 0;
+		int64_t max_wait_us = 0;
+	};
+
+	//RAII Checkout - Connection is handed back to the pool when the Lease goes out of scope
+	class Lease {
+	public:
+		Lease(Lease&& other) noexcept;
+		Lease& operator=(Lease&&) = delete;
+		Lease(const Lease&) = delete;
+		Lease& operator=(const Lease&) = delete;
+		~Lease();
+
+		pqxx::connection& operator*() const { return *_conn; }
+		pqxx::connection* operator->() const { return _conn; }
+
+	private:
+		friend class Connection_Pool;
+		Lease(Connection_Pool* pool, std::size_t slot, pqxx::connection* conn, bool owned);
+
+		Connection_Pool* _pool;
+		std::size_t _slot;
+		pqxx::connection* _conn;
+		bool _owned;
+	};
+
+	Lease acquire();
+	//Binds one connection to the calling thread until the matching unpin, e.g. for BEGIN/COMMIT spans
+	//A pinned connection that drops is reconnected on the next acquire, unless a transaction pin is held - then acquire throws
+	void pin_thread(bool in_transaction = false);
+	void unpin_thread(bool in_transaction = false);
+	bool is_thread_pinned() const;
+
+	Stats get_stats();
+
+private:
+	std::string _connection_string;
+	Setup_Function _on_connect;
+
+	std::mutex _pool_mtx;
+	std::condition_variable _pool_cv;
+	std::vector<std::unique_ptr<pqxx::connection>> _connections;
+	std::vector<std::size_t> _idle_slots;
+	Stats _stats;
+
+	std::unique_ptr<pqxx::connection> connect();
+	std::size_t checkout();
+	//Only for a slot the caller holds exclusively
+	void reconnect_if_closed(std::size_t slot);
+	void release(std::size_t slot);
+};
+
+#endif // TRACKERBOT_CONNECTION_POOL_H
@@ -0,0 +1,55 @@
+#ifndef TRACKERBOT_EDIT_SCHEDULER_H
+#define TRACKERBOT_EDIT_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//Decides when each tracked comment is next checked for edits
+//Comments back off exponentially within a tier picked by the time since their last activity (post or edit)
+//Not thread-safe - owned by the edit detection stage
+class Edit_Scheduler {
+public:
+	//Comment ID - Post Epoch as stored (the edit time once an edit has been recorded), one SQL page at a time
+	using Stored_Epochs = std::vector<std::pair<std::string, int64_t>>;
+
+	//A sync is a mark & sweep over the paged SQL walk, so no copy of the whole window is ever built
+	void begin_sync();
+	//Adds newly tracked comments & restarts the backoff of comments whose stored epoch moved
+	void sync_page(const Stored_Epochs& page, int64_t now);
+	//Drops every comment the walk since begin_sync didn't see
+	void end_sync();
+
+	//The stored epoch the schedule last saw for a comment, if it's tracked
+	std::optional<int64_t> stored_epoch(const std::string& comment_id) const;
+	//Due comment IDs, soonest first, padded with the next upcoming ones so every batch is full
+	std::vector<std::string> take_due(int64_t now, std::size_t batch_size) const;
+	void record_check(const std::string& comment_id, int64_t now, bool edited);
+
+	std::size_t size() const;
+
+private:
+	struct Tier {
+		int64_t max_age;
+		int64_t min_interval;
+		int64_t max_interval;
+	};
+	struct Entry {
+		int64_t stored_epoch;
+		uint64_t generation;
+		int64_t last_activity;
+		int64_t interval;
+		int64_t next_check;
+	};
+
+	static const Tier& tier_for(int64_t age);
+
+	std::unordered_map<std::string, Entry> _entries;
+	uint64_t _generation = 0;
+};
+
+#endif // TRACKERBOT_EDIT_SCHEDULER_H
\ No newline at end of file
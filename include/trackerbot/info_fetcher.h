@@ -0,0 +1,44 @@
+#ifndef TRACKERBOT_INFO_FETCHER_H
+#define TRACKERBOT_INFO_FETCHER_H
+
+#include "rate_limiter.h"
+
+#include <redditcpp/api.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//Looks comments up through /api/info, which answers at most 100 IDs per call
+//Long lists are split into full chunks that run concurrently, each taking its own token from the shared limiter
+class Info_Fetcher {
+public:
+	struct Result {
+		//Comment ID - Comment; deleted comments are still returned, authored by "[deleted]"
+		std::unordered_map<std::string, reddit::Comment> comments;
+		//Requested IDs Reddit had nothing for - never truncation, as every chunk fits in one call
+		std::vector<std::string> missing;
+	};
+
+	static constexpr std::size_t chunk_size = 100;
+
+	Info_Fetcher(std::shared_ptr<reddit::Api> api, Rate_Limiter& limiter, int max_concurrency);
+
+	Info_Fetcher(const Info_Fetcher&) = delete;
+	Info_Fetcher& operator=(const Info_Fetcher&) = delete;
+
+	//Comment IDs without the "t1_" prefix; duplicates are requested once
+	//Throws the first chunk failure once every chunk has finished
+	Result fetch(const std::vector<std::string>& comment_ids, Rate_Limiter::Priority priority);
+
+private:
+	std::shared_ptr<reddit::Api> _reddit_api;
+	Rate_Limiter& _limiter;
+	std::size_t _max_concurrency;
+
+	reddit::CommentListings fetch_chunk(const std::vector<std::string>& fullnames, Rate_Limiter::Priority priority);
+};
+
+#endif // TRACKERBOT_INFO_FETCHER_H
\ No newline at end of file
@@ -0,0 +1,81 @@
+#ifndef TRACKERBOT_LRU_CACHE_H
+#define TRACKERBOT_LRU_CACHE_H
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+//Thread-safe, fixed-capacity cache that evicts the least recently used entry
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class LRU_Cache {
+public:
+	explicit LRU_Cache(std::size_t capacity)
+		: _capacity(capacity == 0 ? 1 : capacity)
+	{
+		_lookup.reserve(_capacity);
+	}
+
+	std::optional<Value> get(const Key& key) {
+		std::lock_guard<std::mutex> lock(_cache_mtx);
+
+		const auto itr = _lookup.find(key);
+		if(itr == _lookup.end()) {
+			return std::nullopt;
+		}
+		_entries.splice(_entries.begin(), _entries, itr->second);
+
+		return itr->second->second;
+	}
+	void put(const Key& key, Value value) {
+		std::lock_guard<std::mutex> lock(_cache_mtx);
+
+		const auto itr = _lookup.find(key);
+		if(itr != _lookup.end()) {
+			itr->second->second = std::move(value);
+			_entries.splice(_entries.begin(), _entries, itr->second);
+			return;
+		}
+
+		_entries.emplace_front(key, std::move(value));
+		_lookup.emplace(key, _entries.begin());
+
+		if(_entries.size() > _capacity) {
+			_lookup.erase(_entries.back().first);
+			_entries.pop_back();
+		}
+	}
+	void erase(const Key& key) {
+		std::lock_guard<std::mutex> lock(_cache_mtx);
+
+		const auto itr = _lookup.find(key);
+		if(itr == _lookup.end()) {
+			return;
+		}
+		_entries.erase(itr->second);
+		_lookup.erase(itr);
+	}
+	void clear() {
+		std::lock_guard<std::mutex> lock(_cache_mtx);
+
+		_entries.clear();
+		_lookup.clear();
+	}
+	std::size_t size() {
+		std::lock_guard<std::mutex> lock(_cache_mtx);
+		return _entries.size();
+	}
+
+private:
+	using Entry_List = std::list<std::pair<Key, Value>>;
+
+	std::mutex _cache_mtx;
+	std::size_t _capacity;
+	Entry_List _entries;
+	std::unordered_map<Key, typename Entry_List::iterator, Hash> _lookup;
+};
+
+#endif // TRACKERBOT_LRU_CACHE_H
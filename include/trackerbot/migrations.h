@@ -0,0 +1,17 @@
+#ifndef TRACKERBOT_MIGRATIONS_H
+#define TRACKERBOT_MIGRATIONS_H
+
+#include <string>
+#include <vector>
+
+//One versioned step of the per-subreddit schema - statements are fmt templates with {0} as the schema name
+struct Schema_Migration {
+	int version;
+	std::string description;
+	std::vector<std::string> statements;
+};
+
+//Ordered by version; append new steps, never edit one that has shipped
+const std::vector<Schema_Migration>& schema_migrations();
+
+#endif // TRACKERBOT_MIGRATIONS_H
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef TRACKERBOT_RATE_LIMITER_H
+#define TRACKERBOT_RATE_LIMITER_H
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+//Token bucket shared by every Reddit API call
+//Waiters are served strictly by lane, and the refill rate halves whenever Reddit refuses a request
+class Rate_Limiter {
+public:
+	enum class Priority {
+		INTERACTIVE,	//Moderator-initiated - menus, approvals, removals
+		INGEST,			//New comment polling & automatic approvals
+		BACKGROUND,		//Edit detection, sticky edits & forced updates
+
+		PRIORITY_COUNT
+	};
+
+	Rate_Limiter(double requests_per_minute, int burst);
+
+	Rate_Limiter(const Rate_Limiter&) = delete;
+	Rate_Limiter& operator=(const Rate_Limiter&) = delete;
+	Rate_Limiter(Rate_Limiter&&) = delete;
+	Rate_Limiter& operator=(Rate_Limiter&&) = delete;
+
+	//Blocks until a token is free & no higher lane is waiting for one
+	void acquire(Priority priority);
+	//Additive recovery towards the configured rate
+	void report_success();
+	//Halves the rate & pauses every lane for a while
+	void report_throttled();
+
+	template<typename Func>
+	auto call(Priority priority, Func&& func) -> std::invoke_result_t<Func> {
+		acquire(priority);
+		try {
+			if constexpr(std::is_void_v<std::invoke_result_t<Func>>) {
+				func();
+				report_success();
+			}
+			else {
+				auto res = func();
+				report_success();
+				return res;
+			}
+		}
+		catch(const std::exception& e) {
+			if(is_throttle_error(e)) {
+				report_throttled();
+			}
+			throw;
+		}
+	}
+
+	double requests_per_minute();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr double min_rate_fraction = 0.1;
+	static constexpr double recovery_fraction = 0.05;
+	static constexpr std::chrono::seconds throttle_pause{ 10 };
+
+	std::mutex _limiter_mtx;
+	std::condition_variable _limiter_cv;
+	//Tokens per second
+	double _max_rate;
+	double _rate;
+	double _burst;
+	double _tokens;
+	Clock::time_point _last_refill;
+	Clock::time_point _paused_until;
+	std::array<int, static_cast<std::size_t>(Priority::PRIORITY_COUNT)> _waiting{};
+
+	void refill(Clock::time_point now);
+	bool higher_lane_waiting(Priority priority) const;
+	static bool is_throttle_error(const std::exception& e);
+	static bool contains_token(const std::string& message, const std::string& token);
+};
+
+#endif // TRACKERBOT_RATE_LIMITER_H
\ No newline at end of file
@@ -1,19 +1,33 @@
 #ifndef TRACKERBOT_SQL_H
 #define TRACKERBOT_SQL_H
 
+#include "comment_index.h"
+#include "connection_pool.h"
+#include "lru_cache.h"
+#include "startup_timer.h"
 #include "types.h"
+#include "update_listener.h"
+#include "username_interner.h"
 
 #include <pqxx/pqxx>
 
-#include <mutex> 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 class sql_handler {
+	enum class Prepareds;
+
 public:
-	sql_handler(std::string subreddit, std::string admin_credentials, std::string conn_string);
+	//Startup phases are recorded into timer when one is given
+	sql_handler(std::string subreddit, std::string admin_credentials, std::string conn_string, int pool_size, Startup_Timer* timer = nullptr);
 
 	struct Dev_Ratio {
 		int all_total = 0;
@@ -28,20 +42,88 @@ public:
 		int64_t epoch_time = 0;
 		std::string comment_text;
 	};
+	struct Thread_Snapshot {
+		std::string sticky_id;
+		//FNV-1a of the sticky body last published, if any
+		std::optional<int64_t> body_digest;
+		std::vector<Comment_Response> comments;
+		//Owner Comment ID - Context Text
+		std::unordered_map<std::string, std::string> contexts;
+	};
+	struct Status_Change {
+		std::string thread_id;
+		std::string dev;
+		int old_status = 0;
+		//The stored comment, so callers can act on it without asking Reddit again
+		int64_t created_epoch = 0;
+		std::string comment_text;
+	};
+	struct Pending_Approval {
+		std::string comment_id;
+		int status = 0;
+		//The stored comment, so the job is rebuilt without asking Reddit again
+		std::string thread_id;
+		std::string dev;
+		int64_t created_epoch = 0;
+		std::string comment_text;
+	};
+	struct Archive_Result {
+		int comments = 0;
+		int contexts = 0;
+		int orphaned_contexts = 0;
+	};
+	//What a Write_Batch entry does, so results are told apart by kind rather than by position
+	enum class Batch_Write { UPDATE_COMMENT, DELETE_COMMENT, ENQUEUE_UPDATE };
+	struct Batch_Result {
+		Batch_Write write = Batch_Write::UPDATE_COMMENT;
+		bool success = false;
+		int affected_rows = 0;
+		std::string error;
+	};
+
+	//Queued prepared-statement executions, sent to the server in one pipelined flush by execute_batch
+	class Write_Batch {
+	public:
+		void update_comment(const std::string& comment_id, const std::string& text, int64_t modified_epoch);
+		void delete_comment(const std::string& comment_id);
+		void enqueue_update(const std::string& thread_id);
+
+		std::size_t size() const;
+		bool empty() const;
+
+	private:
+		friend class sql_handler;
+
+		struct Entry {
+			Batch_Write write;
+			Prepareds statement;
+			std::vector<std::string> params;
+		};
+		std::vector<Entry> _entries;
+	};
+	//Comment ID - Post Epoch
+	using Comment_Epoch_Page = std::vector<std::pair<std::string, int64_t>>;
+	//Maps a dev's name to its interned ID once per write - invalid_id for devs that aren't tracked
+	using Dev_Id_Resolver = std::function<Username_Interner::Id(std::string_view)>;
+	//Invoked with (dev ID, total delta, pinned delta) whenever a write changes a tracked dev's comment counts
+	using Dev_Stats_Listener = std::function<void(Username_Interner::Id, int, int)>;
+
 	bool admin_check_setup_status();
+	void set_dev_stats_listener(Dev_Id_Resolver resolve, Dev_Stats_Listener listener);
 
 	std::unordered_map<std::string, Target> get_dev_map();
 	std::pair<int, int> get_total_pinned();
 	Dev_Ratio get_dev_ratio(const std::string& dev);
 
-	void insert_thread(const std::string& thread_id, const std::string& sticky_id);
+	void insert_thread(const std::string& thread_id, const std::string& sticky_id, int64_t body_digest);
+	void set_thread_digest(const std::string& thread_id, int64_t body_digest);
 	void delete_thread(const std::string& thread_id);
 	std::string get_thread_id(const std::string& comment_id);
 
 	void insert_comment(const std::string& comment_id, const std::string& thread_id, 
-		const std::string& dev, int status, const std::string& supervisor, int64_t supervisor_id, int64_t epoch_time, const std::string& comment_text);
+		const std::string& dev, int status, const std::string& supervisor, int64_t supervisor_id, int64_t epoch_time, int64_t created_epoch, const std::string& comment_text);
 	void update_comment(const std::string& comment_id, const std::string& text, int64_t modified_epoch);
-	std::string change_comment_status(const std::string& comment_id, int status, const std::string& supervisor, int64_t supervisor_id);
+	Status_Change change_comment_status(const std::string& comment_id, int status, const std::string& supervisor, int64_t supervisor_id);
 	bool get_comment_status(const std::string& comment_id);
 	void delete_comment(const std::string& comment_id);
 
@@ -53,6 +135,17 @@ public:
 	void dequeue_update(const std::string& thread_id);
 	int update_queue_size(const std::string& thread_id);
 	std::unordered_set<std::string> get_update_queue();
+
+	//Small persisted key/value store for poll cursors - empty string if the key was never set
+	std::string get_tracker_state(const std::string& key);
+	void set_tracker_state(const std::string& key, const std::string& value);
+	//Durable record of the approval stage's work - written with the comment, cleared once the approval is dispatched
+	void insert_pending_approval(const std::string& comment_id, int status);
+	void delete_pending_approval(const std::string& comment_id);
+	//Oldest first; rows whose comment is gone are dropped
+	std::vector<Pending_Approval> get_pending_approvals();
+	//Called with the Thread ID each time enqueue_update adds a thread that was not already queued
+	std::unique_ptr<Update_Listener> listen_for_updates(Update_Listener::Notify_Function on_enqueue);
 	
 	void upsert_dev(const std::string& dev, const std::string& expertise, Target::Status status, const std::string& supervisor, int64_t supervisor_id);
 	void update_dev_status(const std::string& dev, Target::Status new_status, const std::string& supervisor, int64_t supervisor_id);
@@ -64,41 +157,85 @@ public:
 
 	std::string get_sticky_id(const std::string& thread_id);
 
-	bool check_comment_existence(const std::string& comment_id);		
+	//Answered from the in-memory index where possible; only Bloom filter hits go to the database
+	bool check_comment_existence(const std::string& comment_id);
+	void warm_comment_index(int recent_days);
 	std::vector<Comment_Response> get_comments_in_thread(const std::string& thread_id);
+	//Sticky ID, approved comments & their contexts in one query, served from the thread cache when warm
+	std::shared_ptr<const Thread_Snapshot> get_thread_snapshot(const std::string& thread_id);
 	
-	std::vector<std::string> get_thread_ids_by_date(int days);
-	std::vector<std::string> get_comment_ids_by_date(int days);
+	//Keyset-paginated walks over the last n days, newest first - each chunk is fetched only once the previous one
+	//has been handled, so memory stays bounded however wide the window is
+	void for_each_thread_id_page(int days, int page_size, const std::function<void(const std::vector<std::string>&)>& on_page);
+	void for_each_comment_epoch_page(int days, int page_size, const std::function<void(const Comment_Epoch_Page&)>& on_page);
 	std::vector<std::string> get_comment_ids_by_thread_id(const std::string& thread_id);
-	std::map<std::string, int64_t> get_comment_id_epoch_pair_by_date(int days);
 	std::map<std::string, int64_t> get_comment_id_epoch_pair_by_thread_id(const std::string& thread_id);
 	
+	//Moves threads with no comment activity in the last n days into the archive tables & drops contexts
+	//whose comment is gone - dev_stats & existence checks still see archived rows
+	Archive_Result archive_cold_threads(int days);
+	//Pulls an archived thread back into the hot tables; false if nothing was archived
+	bool restore_archived_thread(const std::string& thread_id);
+	bool restore_archived_comment(const std::string& comment_id);
+
 	void begin_transaction();
 	void commit_transaction();
+	void rollback_transaction();
+
+	//Keeps one pooled connection bound to the calling thread until released - for long-lived workers
+	void reserve_thread_connection();
+	void release_thread_connection();
+
+	//Results are index-aligned with the batch; not for use between begin_transaction & commit_transaction
+	std::vector<Batch_Result> execute_batch(const Write_Batch& batch);
+
+	Connection_Pool::Stats get_pool_stats();
 
 private:
 	std::string _target_subreddit;
 	std::string _admin_login_string;
 	std::string _connection_string;
+	//Matches the LOWER(current_schema()) || '_update_queue' channel Enqueue_Update notifies on
+	std::string _update_channel;
+
+	std::unique_ptr<Connection_Pool> _pool;
 
-	pqxx::connection* conn;
-	std::mutex conn_mtx;
+	Dev_Id_Resolver _dev_id_resolver;
+	Dev_Stats_Listener _dev_stats_listener;
+	Comment_Index _comment_index;
+
+	static constexpr std::size_t thread_cache_capacity = 256;
+	static constexpr double plan_check_min_rows = 10000;
+	static constexpr int comment_index_page_size = 10000;
+	LRU_Cache<std::string, std::shared_ptr<const Thread_Snapshot>> _thread_cache{ thread_cache_capacity };
+	//Bumped by every cache write so a snapshot read concurrently with a write is never cached
+	std::atomic<uint64_t> _thread_cache_generation{ 0 };
+	std::mutex _thread_cache_write_mtx;
 
 	pqxx::result admin_query(const std::string& query_string);
-	bool admin_existence_query(const std::string& query_string);
-	bool validate_subreddit_schema(const std::string& subreddit);
+	bool validate_subreddit_schema(pqxx::connection& conn, const std::string& subreddit);
+	void run_schema_migrations(pqxx::connection& conn);
+	//Fails startup if a hot prepared statement on a table past plan_check_min_rows isn't planned on its index
+	void verify_query_plans();
+	void notify_dev_stats(const std::string& dev, int total_delta, int pinned_delta);
+	std::string batch_query(const pqxx::transaction_base& txn, const Write_Batch::Entry& entry);
+	void apply_batch_result(const Write_Batch::Entry& entry, const pqxx::result& r);
+	void invalidate_thread(const std::string& thread_id);
+	//Restores on the caller's transaction - the pinned connection can only run one at a time
+	bool restore_archived_thread(pqxx::transaction_base& txn, const std::string& thread_id);
+	bool restore_archived_comment(pqxx::transaction_base& txn, const std::string& comment_id);
+	void patch_thread(const std::string& thread_id, const std::function<void(Thread_Snapshot&)>& patch);
+	void remove_from_thread(const std::string& thread_id, const std::string& comment_id);
 
 	enum class Prepareds {
 		//Devs
-		GET_DEV_MAP, GET_DEVEDITS_SESSIONS, GET_TOTAL_PINNED, GET_DEV_RATIO,
+		GET_TOTAL_PINNED, GET_DEV_RATIO,
 		//Threads & Comments (Inserts & Updates)
-		INSERT_THREAD, DELETE_THREAD, GET_THREAD_ID,  
+		INSERT_THREAD, DELETE_THREAD, GET_THREAD_ID, SET_THREAD_DIGEST,  
 		INSERT_COMMENT, UPDATE_COMMENT, CHANGE_COMMENT_STATUS, GET_COMMENT_STATUS,
 		DELETE_COMMENT,
 		//Contexts
 		INSERT_CONTEXT, GET_CONTEXT, GET_CONTEXTS_BY_THREAD,
-		//Approval Queue
-		ENQUEUE_APPROVAL, DEQUEUE_APPROVAL, CHECK_IF_QUEUED,
 		//Update Queue
 		ENQUEUE_UPDATE, DEQUEUE_UPDATE, UPDATE_QUEUE_SIZE, GET_UPDATE_QUEUE,
 		//Devs
@@ -107,15 +244,21 @@ private:
 		//Sticky ID
 		GET_STICKY_ID,
 		//Comments
-		CHECK_COMMENT_EXIST, GET_OTHER_COMMENTS, 
-		GET_THREAD_IDS_BY_DATE, GET_COMMENT_IDS_BY_DATE, GET_COMMENT_IDS_BY_THREAD, 
-		COMMENT_EPOCH_PAIRS_BY_DATE, COMMENT_EPOCH_PAIRS_BY_THREAD
-	};
-	struct Prep_Stm {
-		std::string name;
-		std::string statement;
+		CHECK_COMMENT_EXIST, GET_OTHER_COMMENTS, GET_THREAD_SNAPSHOT,
+		THREAD_ID_PAGE_BY_DATE, COMMENT_EPOCH_PAGE_BY_DATE, GET_COMMENT_IDS_BY_THREAD, 
+		COMMENT_EPOCH_PAIRS_BY_THREAD, COMMENT_ID_PAGE,
+		//Archive
+		ARCHIVE_COLD_THREADS, DROP_ORPHAN_CONTEXTS, RESTORE_THREAD, GET_ARCHIVED_THREAD_ID,
+		ARCHIVED_COMMENT_ID_PAGE,
+		//Tracker State
+		GET_TRACKER_STATE, SET_TRACKER_STATE,
+		//Pending Approvals
+		INSERT_PENDING_APPROVAL, DELETE_PENDING_APPROVAL, GET_PENDING_APPROVALS,
+
+		STATEMENT_COUNT
 	};
-	std::map<Prepareds, Prep_Stm> prepared_statements;
+	//Compile-time table of statement names, SQL & parameter/column types - defined in sql.cpp
+	struct Statement_Registry;
 };
 
 #endif // TRACKERBOT_SQL_H
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef TRACKERBOT_STARTUP_TIMER_H
+#define TRACKERBOT_STARTUP_TIMER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//Records how long each startup phase took - phases may run concurrently from several threads
+class Startup_Timer {
+public:
+	struct Phase {
+		std::string name;
+		int64_t elapsed_ms;
+	};
+
+	Startup_Timer()
+		: _started(std::chrono::steady_clock::now())
+	{
+	}
+
+	template<typename Func>
+	auto time(const std::string& name, Func&& func) -> std::invoke_result_t<Func> {
+		const auto phase_start = std::chrono::steady_clock::now();
+		struct Recorder {
+			Startup_Timer* timer;
+			const std::string& name;
+			std::chrono::steady_clock::time_point phase_start;
+			~Recorder() { timer->record(name, phase_start); }
+		} recorder{ this, name, phase_start };
+
+		return func();
+	}
+
+	std::vector<Phase> phases() {
+		std::lock_guard<std::mutex> lock(_phase_mtx);
+		return _phases;
+	}
+	int64_t total_ms() const {
+		return elapsed_since(_started);
+	}
+	std::string summary() {
+		std::string res;
+		for(const Phase& phase : phases()) {
+			res += (res.empty() ? "" : ", ") + phase.name + " " + std::to_string(phase.elapsed_ms) + "ms";
+		}
+
+		return res;
+	}
+
+private:
+	std::chrono::steady_clock::time_point _started;
+	std::mutex _phase_mtx;
+	std::vector<Phase> _phases;
+
+	static int64_t elapsed_since(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+	void record(const std::string& name, std::chrono::steady_clock::time_point phase_start) {
+		const int64_t elapsed = elapsed_since(phase_start);
+
+		std::lock_guard<std::mutex> lock(_phase_mtx);
+		_phases.push_back({ name, elapsed });
+	}
+};
+
+#endif // TRACKERBOT_STARTUP_TIMER_H
\ No newline at end of file
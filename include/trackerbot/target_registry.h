@@ -0,0 +1,64 @@
+#ifndef TRACKERBOT_TARGET_REGISTRY_H
+#define TRACKERBOT_TARGET_REGISTRY_H
+
+#include "types.h"
+#include "username_interner.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+//Copy-on-write table of tracked devs
+//Readers load the current version atomically & never lock; writers build the next version beside it
+//& swap it in, so a snapshot a reader holds never changes underneath it
+class Target_Registry {
+public:
+	struct Table {
+		uint64_t version = 0;
+		//Indexed by interned username ID - devs that aren't tracked hold an empty Target
+		std::vector<Target> targets;
+		std::size_t tracked = 0;
+
+		//nullptr if the dev isn't tracked
+		const Target* find(Username_Interner::Id id) const;
+	};
+	using Modifier = std::function<void(Target::Data&)>;
+
+	Target_Registry();
+
+	Target_Registry(const Target_Registry&) = delete;
+	Target_Registry& operator=(const Target_Registry&) = delete;
+
+	std::shared_ptr<const Table> snapshot() const;
+	//Case-insensitive & allocation free; empty Target if the dev isn't tracked
+	Target find(std::string_view username) const;
+	//invalid_id for a name that was never tracked
+	Username_Interner::Id id_of(std::string_view username) const;
+
+	//Replaces every entry in one version
+	void assign(const std::vector<Target>& targets);
+	//Leaves an already tracked dev untouched
+	void emplace(const Target& target);
+	void remove(std::string_view username);
+	//Publishes a modified copy of the dev's data & returns it - empty Target if the dev isn't tracked
+	Target update(std::string_view username, const Modifier& modify);
+	//Adjusts the dev's counters in place - no new version, so ingest bursts never copy the table
+	//Keyed by id_of() so the hot path never hashes the name
+	void add_stats(Username_Interner::Id id, int total_delta, int pinned_delta) const;
+
+private:
+	Username_Interner _usernames;
+	//Only ever accessed through the std::atomic_* shared_ptr overloads
+	std::shared_ptr<const Table> _table;
+	//Serialises writers only
+	std::mutex _writer_mtx;
+
+	void publish(const Table& current, std::vector<Target> targets, std::size_t tracked);
+	static void ensure_stats(Target& target);
+};
+
+#endif // TRACKERBOT_TARGET_REGISTRY_H
\ No newline at end of file
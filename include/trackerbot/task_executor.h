@@ -0,0 +1,52 @@
+#ifndef TRACKERBOT_TASK_EXECUTOR_H
+#define TRACKERBOT_TASK_EXECUTOR_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Plain worker threads for continuations that block on something other than Postgres,
+//so Async_SQL callbacks can hand them off instead of holding a SQL worker through a Reddit call
+class Task_Executor {
+public:
+	using Task = std::function<void()>;
+	using Error_Callback = std::function<void(std::exception_ptr)>;
+
+	Task_Executor(std::string name, int worker_count);
+	~Task_Executor();
+
+	Task_Executor(const Task_Executor&) = delete;
+	Task_Executor& operator=(const Task_Executor&) = delete;
+	Task_Executor(Task_Executor&&) = delete;
+	Task_Executor& operator=(Task_Executor&&) = delete;
+
+	//Errors go to on_error, or the log if none is given
+	void post(Task task, Error_Callback on_error = nullptr);
+
+	std::size_t pending();
+
+private:
+	struct Job {
+		Task task;
+		Error_Callback on_error;
+	};
+
+	std::string _name;
+
+	std::mutex _queue_mtx;
+	std::condition_variable _queue_cv;
+	std::deque<Job> _jobs;
+	bool _stopping = false;
+	std::vector<std::thread> _workers;
+
+	void worker_loop();
+	void report_error(const Error_Callback& on_error, std::exception_ptr error) const;
+};
+
+#endif // TRACKERBOT_TASK_EXECUTOR_H
\ No newline at end of file
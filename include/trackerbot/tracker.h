@@ -1,15 +1,34 @@
 #ifndef TRACKERBOT_TRACKER_H
 #define TRACKERBOT_TRACKER_H
 
+#include "async_sql.h"
+#include "bounded_queue.h"
+#include "edit_scheduler.h"
+#include "info_fetcher.h"
+#include "lru_cache.h"
+#include "rate_limiter.h"
 #include "sql.h"
+#include "task_executor.h"
 #include "tracker.h"
 #include "trackercfg.h"
+#include "update_coalescer.h"
 #include "types.h"
 
 #include <dpp/dpp.h>
 #include <redditcpp/api.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 class Tracker {
 public:
@@ -21,12 +40,18 @@ public:
 	Tracker(Tracker&&) = delete;
 	Tracker& operator=(Tracker&&) = delete;
 
+	//Connects SQL, authenticates with Reddit & loads the dev map on a background thread, so the gateway can connect meanwhile
+	void begin_startup();
+	//Blocks until startup finishes; false if it failed
+	bool wait_until_ready();
+	bool is_ready() const;
+
 	TrackerConfig::Discord_Config get_discord_config();
 	void reload_config();
 	bool permissions_check(const dpp::interaction_create_t& event, User::Permission req_perm_level);
 
-	void approve_post(const std::string& comment_id, const std::string& supervisor_username, int64_t supervisor_id);
-	void deny_post(const std::string& comment_id, const std::string& supervisor_username, int64_t supervisor_id);
+	void approve_post(const dpp::interaction_create_t& event, const std::string& comment_id);
+	void deny_post(const dpp::interaction_create_t& event, const std::string& comment_id);
 	void switch_comment_status(const dpp::interaction_create_t& event, const std::string& comment_id);
 
 	void print_target_list(int64_t channel_id);
@@ -35,6 +60,8 @@ public:
 	void tracker_iterate();
 	void update_finder_iterate();
 	void update_iterate();
+	//Schedules a queued thread with the sticky-publish stage; an empty ID asks for a sweep of the whole update queue
+	void wake_sticky_updater(const std::string& thread_id = "");
 
 	void add_target_menu(const dpp::interaction_create_t& event, const std::string& target);
 	void edit_target_menu(const dpp::interaction_create_t& event, const std::string& target_name);
@@ -44,26 +71,106 @@ public:
 	void add_target_to_tracker(const dpp::interaction_create_t& event, const std::string& target_name);
 	bool suspend_target(const dpp::interaction_create_t& event, const std::string& target_name);
 
-	int force_update(int days);
+	//Updates every thread of the last n days in the background, reporting progress on a channel message with a Cancel button
+	void force_update(const dpp::interaction_create_t& event, int days);
+	void cancel_force_update(const dpp::interaction_create_t& event);
 
 private:
 	dpp::cluster* _bot;
 	std::shared_ptr<reddit::Api> _reddit_api;
+	//Every Reddit request after auth goes through here
+	std::unique_ptr<Rate_Limiter> _reddit_limiter;
+	//Every /api/info lookup - keeps long ID lists from being truncated at 100
+	std::unique_ptr<Info_Fetcher> _info_fetcher;
 	std::shared_ptr<sql_handler> _sql;
+	//Declared after _sql so its workers are joined before the handler goes away
+	std::unique_ptr<Async_SQL> _async_sql;
+	//Reddit continuations of Async_SQL jobs - one worker, so each approval reads the thread's snapshot only after
+	//the one before it has published, & two approvals on a thread never both post a sticky
+	std::unique_ptr<Task_Executor> _reddit_tasks;
 	std::unique_ptr<TrackerConfig> _cfg_handler;
 	std::atomic_bool _tracker_on_flag;
+	std::atomic_bool _ready{ false };
+	std::shared_future<void> _startup;
+
+	//Pipeline stages - ingest feeds approvals, update queue NOTIFYs feed sticky publishing
+	struct Approval_Job {
+		reddit::Comment comment;
+		Target::Status status;
+		//Failed automatic approvals go back on the queue until approval_max_attempts
+		int attempts = 0;
+	};
+	Bounded_Queue<Approval_Job> _approval_queue{ approval_queue_capacity };
+	//pending_approvals rows left by the last run - loaded at startup & queued by the ingest stage ahead of its first pass
+	std::vector<Approval_Job> _recovered_approvals;
+	//Comment IDs approved without a refetch - the edit detection stage checks them for deletion first
+	Bounded_Queue<std::string> _deletion_checks{ deletion_check_capacity };
+	std::unique_ptr<Update_Coalescer> _update_coalescer;
+	//Set when a thread didn't fit in the coalescer or the LISTEN was re-established - the next publish pass sweeps the whole update queue
+	std::atomic_bool _publish_resync{ false };
+	std::atomic<uint64_t> _sticky_edits_sent{ 0 };
+	std::atomic<uint64_t> _sticky_edits_skipped{ 0 };
+	//Only read by the sticky publish stage, so it is torn down once that stage is joined
+	std::unique_ptr<Update_Listener> _update_listener;
+	//Every stage captures this, so ~Tracker stops & joins them before any member goes away
+	std::vector<std::thread> _stage_threads;
+	std::mutex _stop_mtx;
+	std::condition_variable _stop_cv;
+	bool _stages_stopped = false;
+
+	//Held from the click until the job's final progress edit - only one force update runs at a time
+	std::atomic_bool _force_update_running{ false };
+	std::atomic_bool _force_update_cancel{ false };
+	std::mutex _force_update_mtx;
+	std::future<void> _force_update_job;
+
+	//Fullname of the newest friends-feed comment already ingested - only touched by the ingest stage
+	std::string _friends_feed_mark;
+	//Parent Comment ID - Body of recently fetched contexts; busy threads keep replying to the same parents
+	LRU_Cache<std::string, std::string> _context_cache{ context_cache_capacity };
+	//Only touched by the edit detection stage
+	std::chrono::steady_clock::time_point _last_archive_run = std::chrono::steady_clock::now();
+	Edit_Scheduler _edit_scheduler;
 
 	TrackerConfig::Tracker_Config _tracker_config;
 	TrackerConfig::Discord_Config _discord_config;
 	TrackerConfig::SQL_Config _sql_config;
 	TrackerConfig::Format_Config _format_config;
+	uint64_t _format_version = 0;
+	//"Comment ID:Epoch:Format Version:Expertise" - Rendered sticky entry, without the separating blank line
+	LRU_Cache<std::string, std::string> _fragment_cache{ fragment_cache_capacity };
+
+	static constexpr int reddit_info_batch_size = static_cast<int>(Info_Fetcher::chunk_size);
+	static constexpr int reddit_info_concurrency = 4;
+	//Reddit listings stop at ~1000 items, so catching up further back is impossible anyway
+	static constexpr int friends_feed_max_pages = 10;
+	static constexpr const char* friends_feed_mark_key = "friends_feed_mark";
+	static constexpr std::size_t context_cache_capacity = 2048;
+	static constexpr std::size_t fragment_cache_capacity = 4096;
+	static constexpr std::size_t approval_queue_capacity = 256;
+	static constexpr int approval_max_attempts = 3;
+	static constexpr std::size_t deletion_check_capacity = 256;
+	static constexpr std::size_t update_coalescer_capacity = 1024;
+	static constexpr std::size_t force_update_workers = 4;
+	static constexpr std::chrono::seconds force_update_progress_interval{ 5 };
 
 	static int32_t status_color(Target::Status status);
 	static std::string status_emote(Target::Status status);
 	static std::string status_string(Target::Status status);
 	[[nodiscard]] std::string format_comment_for_discord(const std::string& comment_body, bool is_context = false) const;
 
-	reddit::Comment get_comment(const std::string& comment_id);
+	void startup();
+	//Sleeps between passes; false as soon as the stages are told to stop
+	bool wait_while_running(std::chrono::seconds duration);
+	void stop_stages();
+
+	void approve_automatic(const Approval_Job& job);
+	//Logs an Async_SQL / Reddit task failure & tells the moderator who clicked
+	static Async_SQL::Error_Callback reply_on_error(const dpp::interaction_create_t& event, const std::string& action);
+	//Posts or edits the thread's sticky from an already-updated snapshot; returns the Sticky ID
+	std::string publish_approval(const reddit::Comment& comment, const sql_handler::Thread_Snapshot& snapshot, Rate_Limiter::Priority priority);
+	//Stands in for a Reddit refetch, built from the row change_comment_status returned
+	reddit::Comment stored_comment(const std::string& comment_id, const sql_handler::Status_Change& change) const;
 	void log_post_action(const std::string& user, const reddit::Comment& comment, bool approved, const std::string& sticky_id);
 	
 	void send_for_approval(const reddit::Comment& comment);
@@ -71,13 +178,24 @@ private:
 	std::string generate_sticky_comment(const std::string& author, const std::string& url, int64_t epoch_time, const std::string& comment);
 	std::string preformat_sticky_comment(const std::string& author, const std::string& url, int64_t epoch_time, std::string context, const std::string& comment);
 	std::string preformat_sticky_comment(const std::string& author, const std::string& url, int64_t epoch_time, const std::string& comment);
-	std::string construct_comments(const std::string& thread_id);
+	//Fingerprint of the templates & limits that shape a rendered entry
+	static uint64_t format_version(const TrackerConfig::Format_Config& format);
+	std::string construct_comments(const sql_handler::Thread_Snapshot& snapshot);
+	static int64_t sticky_digest(const std::string& body);
+	//Edits the thread's sticky unless the body matches the last published digest; false if the edit was skipped
+	bool edit_sticky(const std::string& thread_id, const sql_handler::Thread_Snapshot& snapshot, const std::string& body, Rate_Limiter::Priority priority);
 
 	static dpp::embed pre_user_embed(const reddit::UserAbout& user, const reddit::CommentListings& comments, int comment_cap);
 	
 	int update_thread(const std::string& thread_id, const std::map<std::string, int64_t>& timestamps, bool ignore_edit_checks);
 	int update_thread_id(const std::string& thread_id, bool ignore_edit_checks);
-	int update_thread_id_by_days(const std::string& thread_id, int days, bool ignore_edit_checks);
+	void archive_iterate();
+	//Friends-feed comments newer than _friends_feed_mark, newest first
+	std::vector<reddit::Comment> fetch_new_friend_comments();
+	void dispatch_approval(const Approval_Job& job);
+	void publish_threads(const std::unordered_set<std::string>& thread_ids);
+	void publish_thread(const std::string& thread_id);
+	void run_force_update(dpp::message progress_msg, int days);
 };
 
 #endif // TRACKERBOT_TRACKER_H
\ No newline at end of file
@@ -1,9 +1,14 @@
 #ifndef TRACKERBOT_TRACKERCFG_H
 #define TRACKERBOT_TRACKERCFG_H
 
+#include "trackerbot/target_registry.h"
 #include "trackerbot/types.h"
 
+#include <functional>
+#include <memory>
+
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -14,9 +19,15 @@ public:
     struct Tracker_Config {
         std::string target_subreddit;
         int tracker_interval = 0;
+        int edit_check_interval = 0;
         int tracker_iterate_amount = 0;
         int update_day_limit = 0;
+        int archive_interval = 0;
+        int sticky_debounce = 0;
+        int sticky_max_delay = 0;
         float minimum_epoch = 0;
+        double reddit_requests_per_minute = 0;
+        int reddit_burst = 0;
     };
     struct Reddit_Config {
         std::string client_id;
@@ -37,6 +48,8 @@ public:
     struct SQL_Config {
         std::string admin_credentials;
         std::string conn_string;
+        int pool_size = 0;
+        int async_workers = 0;
     };
     struct Format_Config {
         int total_char_limit = 0;
@@ -56,12 +69,16 @@ public:
     SQL_Config get_sql_config();
     Format_Config get_format_config();
 
-    Target target_map_find(const std::string& username);
-    void target_map_reserve(int reserve_count);
+    //Safe from any thread - lookups are case-insensitive, never lock or allocate & every change publishes a new version
+    Target target_map_find(std::string_view username);
+    void target_map_assign(const std::unordered_map<std::string, Target>& targets);
     void target_map_emplace(const Target& target);
-    void target_map_remove(const std::string& username);
+    void target_map_remove(std::string_view username);
+    Target target_map_update(std::string_view username, const Target_Registry::Modifier& modify);
+    Username_Interner::Id target_map_id_of(std::string_view username);
+    void target_map_add_stats(Username_Interner::Id id, int total_delta, int pinned_delta);
+    std::shared_ptr<const Target_Registry::Table> target_map_snapshot();
     User user_map_find(int64_t user_id);
-    std::vector<Target::Data> get_targets_vector_data();
 
 private:
     std::string _cfg_path;
@@ -72,8 +89,8 @@ private:
     SQL_Config _sql_config;
     Format_Config _format_config;
 
-    // //Username - Tracked User
-    std::unordered_map<std::string, Target> _target_map;
+    //Username - Tracked User
+    Target_Registry _target_map;
     // //Managing Message ID - Tracked User
     // std::unordered_map<int64_t, std::shared_ptr<Tracking_Target>> _managing_map;
 
@@ -1,6 +1,7 @@
 #ifndef TRACKERBOT_TYPES_H
 #define TRACKERBOT_TYPES_H
 
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -14,11 +15,17 @@ public:
         Status status = Status::UNKNOWN;
         int64_t managing_msg_id = 0;
         int64_t msg_channel = 0;
-        int dev_total = 0;
-        int dev_pinned = 0;
+    };
+    //Comment counts change with every insert & status change, so they're bumped in place rather than published
+    struct Stats {
+        std::atomic<int> dev_total{ 0 };
+        std::atomic<int> dev_pinned{ 0 };
     };
 
-    std::shared_ptr<Target::Data> data;
+    //Shared with the registry version it was published in - never modified afterwards, see Target_Registry::update
+    std::shared_ptr<const Target::Data> data;
+    //Shared by every registry version of the dev
+    std::shared_ptr<Target::Stats> stats;
     bool is_empty() {
         return data.use_count() == 0 && data == nullptr;
     }
@@ -0,0 +1,48 @@
+#ifndef TRACKERBOT_UPDATE_COALESCER_H
+#define TRACKERBOT_UPDATE_COALESCER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//Merges repeated sticky update requests for a thread into one rebuild
+//A thread is ready once it has been quiet for the debounce window, or max_delay after its first request at the latest
+class Update_Coalescer {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	Update_Coalescer(Clock::duration debounce, Clock::duration max_delay, std::size_t capacity);
+
+	Update_Coalescer(const Update_Coalescer&) = delete;
+	Update_Coalescer& operator=(const Update_Coalescer&) = delete;
+
+	//False if the thread isn't pending yet & there's no room for it
+	bool touch(const std::string& thread_id);
+	void erase(const std::string& thread_id);
+	//Blocks until a thread is ready or max_wait passes, then hands over every ready thread
+	std::vector<std::string> wait_ready(Clock::duration max_wait);
+	void close();
+
+	std::size_t size();
+
+private:
+	struct Pending {
+		Clock::time_point first_touch;
+		Clock::time_point due;
+	};
+
+	Clock::duration _debounce;
+	Clock::duration _max_delay;
+	std::size_t _capacity;
+
+	std::mutex _pending_mtx;
+	std::condition_variable _pending_cv;
+	std::unordered_map<std::string, Pending> _pending;
+	bool _closed = false;
+};
+
+#endif // TRACKERBOT_UPDATE_COALESCER_H
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef TRACKERBOT_UPDATE_LISTENER_H
+#define TRACKERBOT_UPDATE_LISTENER_H
+
+#include <pqxx/pqxx>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+//Holds a dedicated LISTEN connection & hands every NOTIFY payload on the channel to the callback
+//An empty payload is sent each time the LISTEN is (re)established, so missed notifications can be swept up
+class Update_Listener {
+public:
+	using Notify_Function = std::function<void(const std::string&)>;
+
+	Update_Listener(std::string conn_string, std::string channel, Notify_Function on_notify);
+	~Update_Listener();
+
+	Update_Listener(const Update_Listener&) = delete;
+	Update_Listener& operator=(const Update_Listener&) = delete;
+	Update_Listener(Update_Listener&&) = delete;
+	Update_Listener& operator=(Update_Listener&&) = delete;
+
+	//False while the connection is down - callers should lean on their polling fallback
+	bool is_listening() const;
+
+private:
+	std::string _connection_string;
+	std::string _channel;
+	Notify_Function _on_notify;
+
+	std::atomic_bool _running;
+	std::atomic_bool _listening;
+	std::thread _listen_thread;
+
+	void listen_loop();
+};
+
+#endif // TRACKERBOT_UPDATE_LISTENER_H
\ No newline at end of file
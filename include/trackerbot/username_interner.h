@@ -0,0 +1,56 @@
+#ifndef TRACKERBOT_USERNAME_INTERNER_H
+#define TRACKERBOT_USERNAME_INTERNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+//Hash & equality that ignore ASCII case - usable on string_view keys, so lookups never build a lowercase copy
+struct Case_Insensitive_Hash {
+	std::size_t operator()(std::string_view value) const;
+};
+struct Case_Insensitive_Equal {
+	bool operator()(std::string_view lhs, std::string_view rhs) const;
+};
+
+//Gives every Reddit username a small dense ID, treating names that differ only in case as one
+//Append-only & copy-on-write like Target_Registry - lookups take no lock & never allocate
+class Username_Interner {
+public:
+	using Id = uint32_t;
+	static constexpr Id invalid_id = std::numeric_limits<Id>::max();
+
+	Username_Interner();
+
+	Username_Interner(const Username_Interner&) = delete;
+	Username_Interner& operator=(const Username_Interner&) = delete;
+
+	//The existing ID, or a new one on first sight
+	Id intern(std::string_view username);
+	//invalid_id if the name was never interned
+	Id find(std::string_view username) const;
+	//The spelling the name was first interned with
+	std::string name(Id id) const;
+	std::size_t size() const;
+
+private:
+	struct Table {
+		//Indexed by ID; shared between versions, so the views below stay valid in every one of them
+		std::vector<std::shared_ptr<const std::string>> names;
+		std::unordered_map<std::string_view, Id, Case_Insensitive_Hash, Case_Insensitive_Equal> ids;
+	};
+
+	//Only ever accessed through the std::atomic_* shared_ptr overloads
+	std::shared_ptr<const Table> _table;
+	std::mutex _writer_mtx;
+
+	std::shared_ptr<const Table> snapshot() const;
+};
+
+#endif // TRACKERBOT_USERNAME_INTERNER_H
\ No newline at end of file
@@ -1,7 +1,9 @@
 #ifndef TRACKERBOT_UTILITY_H
 #define TRACKERBOT_UTILITY_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 class Utility {
 public:
@@ -12,6 +14,12 @@ public:
 	static void discord_quote_formatting(std::string& string);
 	static std::string discord_timestamp_formatting(int64_t epoch_time);
 
+	//64-bit FNV-1a - cheap change detection, not for anything security related
+	static uint64_t fnv1a_hash(std::string_view data, uint64_t seed = 0xcbf29ce484222325ULL);
+	//ASCII case-insensitive forms of the above, folding each character in place instead of building a lowercase copy
+	static bool iequals(std::string_view lhs, std::string_view rhs);
+	static uint64_t fnv1a_hash_folded(std::string_view data, uint64_t seed = 0xcbf29ce484222325ULL);
+
 private:
 	static void replace_string(std::string& target, const std::string& from, const std::string& to);
 };
@@ -0,0 +1,105 @@
+#include "trackerbot/async_sql.h"
+
+#include "trackerbot/sql.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+Async_SQL::Async_SQL(std::shared_ptr<sql_handler> sql, int worker_count)
+	: _sql(std::move(sql))
+{
+	worker_count = std::max(worker_count, 1);
+
+	_workers.reserve(worker_count);
+	for(int i = 0; i < worker_count; ++i) {
+		_workers.emplace_back(&Async_SQL::worker_loop, this);
+	}
+}
+Async_SQL::~Async_SQL() {
+	{
+		std::lock_guard<std::mutex> lock(_queue_mtx);
+		_stopping = true;
+	}
+	_queue_cv.notify_all();
+
+	for(auto& worker : _workers) {
+		if(worker.joinable()) {
+			worker.join();
+		}
+	}
+}
+
+void Async_SQL::enqueue(Job job) {
+	{
+		std::lock_guard<std::mutex> lock(_queue_mtx);
+		if(_stopping) {
+			throw std::runtime_error("Async SQL executor is shutting down.");
+		}
+		_jobs.emplace_back(std::move(job));
+	}
+	_queue_cv.notify_one();
+}
+std::size_t Async_SQL::pending() {
+	std::lock_guard<std::mutex> lock(_queue_mtx);
+	return _jobs.size();
+}
+
+void Async_SQL::worker_loop() {
+	//Each worker keeps one connection for its lifetime, so queued jobs never compete with the tracker threads for the pool
+	bool reserved = false;
+	try {
+		_sql->reserve_thread_connection();
+		reserved = true;
+	}
+	catch(const std::exception& e) {
+		spdlog::error("Async SQL: Unable to reserve a connection, worker will share the pool - {}", e.what());
+	}
+
+	while(true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(_queue_mtx);
+			_queue_cv.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+			//Drain what was already queued before shutting down
+			if(_jobs.empty()) {
+				break;
+			}
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+		}
+
+		job(*_sql);
+	}
+
+	if(reserved) {
+		_sql->release_thread_connection();
+	}
+}
+
+void Async_SQL::report_error(const Error_Callback& on_error, std::exception_ptr error) {
+	if(on_error) {
+		try {
+			on_error(error);
+		}
+		catch(const std::exception& e) {
+			spdlog::error("Async SQL: Error callback threw - {}", e.what());
+		}
+		return;
+	}
+
+	try {
+		std::rethrow_exception(error);
+	}
+	catch(const std::exception& e) {
+		spdlog::error("Async SQL: Job failed - {}", e.what());
+	}
+	catch(...) {
+		spdlog::error("Async SQL: Job failed with an unknown error");
+	}
+}
\ No newline at end of file
@@ -103,14 +103,12 @@ Commands_Handler::Commands_Handler(dpp::cluster* bot, Tracker* tracker)
             }
         },
         { "approvecomment", [this](const dpp::interaction_create_t& event, const std::string& comment_id) {
-                dpp::user user = event.command.usr;
-                _tracker->approve_post(comment_id, user.username, user.id);
+                _tracker->approve_post(event, comment_id);
                 _bot->message_delete(event.command.msg.id, event.command.msg.channel_id);
             }
         },
         { "rejectcomment", [this](const dpp::interaction_create_t& event, const std::string& comment_id) {
-                dpp::user user = event.command.usr;
-                _tracker->deny_post(comment_id, user.username, user.id);
+                _tracker->deny_post(event, comment_id);
                 _bot->message_delete(event.command.msg.id, event.command.msg.channel_id);
             }
         },
@@ -153,8 +151,11 @@ Commands_Handler::Commands_Handler(dpp::cluster* bot, Tracker* tracker)
             }
         },
         { "force_update", [this](const dpp::interaction_create_t& event, const std::string& days) {
-                event.reply("Force Updating");
-                _tracker->force_update(std::stoi(days));
+                _tracker->force_update(event, std::stoi(days));
+            }
+        },
+        { "cancel_force_update", [this](const dpp::interaction_create_t& event, const std::string& /*unused*/) {
+                _tracker->cancel_force_update(event);
             }
         },
         { "register_commands", [this](const dpp::interaction_create_t& event, const std::string& /*unused*/) {
@@ -0,0 +1,122 @@
+#include "trackerbot/comment_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+namespace {
+	uint64_t mix(uint64_t x) {
+		x += 0x9E3779B97F4A7C15ULL;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+}
+
+bool Comment_Index::pack_id(const std::string& comment_id, uint64_t& packed) {
+	if(comment_id.empty() || comment_id.size() > 12) {
+		return false;
+	}
+
+	packed = 0;
+	for(const char c : comment_id) {
+		uint64_t digit = 0;
+		if(c >= '0' && c <= '9') {
+			digit = c - '0';
+		}
+		else if(c >= 'a' && c <= 'z') {
+			digit = c - 'a' + 10;
+		}
+		else {
+			return false;
+		}
+		packed = packed * 36 + digit;
+	}
+
+	return true;
+}
+
+void Comment_Index::reset(std::size_t expected_count) {
+	std::unique_lock<std::shared_mutex> lock(_index_mtx);
+
+	//Sized for twice the current history so the false-positive rate holds while the table keeps growing
+	_bloom_bit_count = std::max(expected_count * 2 * bloom_bits_per_entry, bloom_min_bits);
+	_bloom.assign((_bloom_bit_count + 63) / 64, 0);
+	_recent.clear();
+	_ready = false;
+}
+void Comment_Index::mark_ready() {
+	std::unique_lock<std::shared_mutex> lock(_index_mtx);
+	_ready = true;
+}
+void Comment_Index::insert(const std::string& comment_id, bool recent) {
+	uint64_t packed = 0;
+	if(!pack_id(comment_id, packed)) {
+		return;
+	}
+
+	std::unique_lock<std::shared_mutex> lock(_index_mtx);
+	//Nothing to record into before the first reset
+	if(_bloom.empty()) {
+		return;
+	}
+	bloom_insert(packed);
+	if(recent) {
+		_recent.insert(packed);
+	}
+}
+void Comment_Index::erase(const std::string& comment_id) {
+	uint64_t packed = 0;
+	if(!pack_id(comment_id, packed)) {
+		return;
+	}
+
+	//Bloom bits stay set - a deleted ID just falls back to a database check
+	std::unique_lock<std::shared_mutex> lock(_index_mtx);
+	_recent.erase(packed);
+}
+Comment_Index::Lookup Comment_Index::lookup(const std::string& comment_id) {
+	uint64_t packed = 0;
+	if(!pack_id(comment_id, packed)) {
+		return Lookup::UNKNOWN;
+	}
+
+	std::shared_lock<std::shared_mutex> lock(_index_mtx);
+	if(!_ready) {
+		return Lookup::UNKNOWN;
+	}
+	if(_recent.count(packed) != 0) {
+		return Lookup::SEEN;
+	}
+
+	return bloom_contains(packed) ? Lookup::UNKNOWN : Lookup::NOT_SEEN;
+}
+std::size_t Comment_Index::recent_size() {
+	std::shared_lock<std::shared_mutex> lock(_index_mtx);
+	return _recent.size();
+}
+
+void Comment_Index::bloom_insert(uint64_t packed) {
+	const uint64_t h1 = mix(packed);
+	const uint64_t h2 = mix(h1) | 1;
+
+	for(int i = 0; i < bloom_hash_count; ++i) {
+		const uint64_t bit = (h1 + i * h2) % _bloom_bit_count;
+		_bloom[bit / 64] |= (1ULL << (bit % 64));
+	}
+}
+bool Comment_Index::bloom_contains(uint64_t packed) const {
+	const uint64_t h1 = mix(packed);
+	const uint64_t h2 = mix(h1) | 1;
+
+	for(int i = 0; i < bloom_hash_count; ++i) {
+		const uint64_t bit = (h1 + i * h2) % _bloom_bit_count;
+		if((_bloom[bit / 64] & (1ULL << (bit % 64))) == 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,202 @@
+#include "trackerbot/connection_pool.h"
+
+#include <pqxx/pqxx>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	constexpr int max_connect_attempts = 6;
+	constexpr std::chrono::milliseconds initial_backoff{ 250 };
+	constexpr std::chrono::milliseconds max_backoff{ 8000 };
+
+	struct Pinned_Connection {
+		const Connection_Pool* pool;
+		std::size_t slot;
+		int depth;
+		//Pins held for a BEGIN/COMMIT span - a reconnect would silently drop the open transaction
+		int transaction_depth;
+	};
+	thread_local std::vector<Pinned_Connection> pinned_connections;
+
+	std::vector<Pinned_Connection>::iterator find_pinned(const Connection_Pool* pool) {
+		return std::find_if(pinned_connections.begin(), pinned_connections.end(),
+			[pool](const Pinned_Connection& pinned) { return pinned.pool == pool; });
+	}
+}
+
+Connection_Pool::Lease::Lease(Connection_Pool* pool, std::size_t slot, pqxx::connection* conn, bool owned)
+	: _pool(pool)
+	, _slot(slot)
+	, _conn(conn)
+	, _owned(owned)
+{
+}
+Connection_Pool::Lease::Lease(Lease&& other) noexcept
+	: _pool(other._pool)
+	, _slot(other._slot)
+	, _conn(other._conn)
+	, _owned(other._owned)
+{
+	other._owned = false;
+	other._conn = nullptr;
+}
+Connection_Pool::Lease::~Lease() {
+	if(_owned) {
+		_pool->release(_slot);
+	}
+}
+
+Connection_Pool::Connection_Pool(std::string conn_string, int pool_size, Setup_Function on_connect)
+	: _connection_string(std::move(conn_string))
+	, _on_connect(std::move(on_connect))
+{
+	pool_size = std::max(pool_size, 1);
+
+	//Connecting & preparing is mostly round trips, so all slots are opened at once
+	std::vector<std::future<std::unique_ptr<pqxx::connection>>> pending;
+	pending.reserve(pool_size);
+	for(int i = 0; i < pool_size; ++i) {
+		pending.emplace_back(std::async(std::launch::async, [this]() { return connect(); }));
+	}
+
+	_connections.reserve(pool_size);
+	_idle_slots.reserve(pool_size);
+	for(int i = 0; i < pool_size; ++i) {
+		_connections.emplace_back(pending[i].get());
+		_idle_slots.emplace_back(i);
+	}
+	_stats.pool_size = pool_size;
+}
+
+std::unique_ptr<pqxx::connection> Connection_Pool::connect() {
+	std::chrono::milliseconds backoff = initial_backoff;
+
+	for(int attempt = 1; ; ++attempt) {
+		try {
+			std::unique_ptr<pqxx::connection> conn = std::make_unique<pqxx::connection>(_connection_string);
+			if(_on_connect) {
+				_on_connect(*conn);
+			}
+			return conn;
+		}
+		catch(const pqxx::broken_connection& e) {
+			if(attempt >= max_connect_attempts) {
+				spdlog::critical("SQL: Unable to connect after {} attempts - {}", attempt, e.what());
+				throw;
+			}
+			spdlog::warn("SQL: Connection attempt {} failed, retrying in {}ms - {}", attempt, backoff.count(), e.what());
+			std::this_thread::sleep_for(backoff);
+			backoff = std::min(backoff * 2, max_backoff);
+		}
+	}
+}
+
+std::size_t Connection_Pool::checkout() {
+	const auto wait_start = std::chrono::steady_clock::now();
+
+	std::unique_lock<std::mutex> lock(_pool_mtx);
+	const bool contended = _idle_slots.empty();
+	_pool_cv.wait(lock, [this]() { return !_idle_slots.empty(); });
+
+	const std::size_t slot = _idle_slots.back();
+	_idle_slots.pop_back();
+
+	const int64_t waited_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wait_start).count();
+	++_stats.checkouts;
+	_stats.contended_checkouts += contended ? 1 : 0;
+	_stats.total_wait_us += waited_us;
+	_stats.max_wait_us = std::max(_stats.max_wait_us, waited_us);
+	lock.unlock();
+
+	//The slot is exclusively ours now, so a dropped connection can be replaced outside the lock
+	try {
+		reconnect_if_closed(slot);
+	}
+	catch(...) {
+		release(slot);
+		throw;
+	}
+
+	return slot;
+}
+void Connection_Pool::reconnect_if_closed(std::size_t slot) {
+	if(_connections[slot]->is_open()) {
+		return;
+	}
+
+	spdlog::warn("SQL: Pooled connection {} was closed, reconnecting", slot);
+	_connections[slot] = connect();
+
+	std::lock_guard<std::mutex> stats_lock(_pool_mtx);
+	++_stats.reconnects;
+}
+void Connection_Pool::release(std::size_t slot) {
+	{
+		std::lock_guard<std::mutex> lock(_pool_mtx);
+		_idle_slots.emplace_back(slot);
+	}
+	_pool_cv.notify_one();
+}
+
+Connection_Pool::Lease Connection_Pool::acquire() {
+	const auto pinned = find_pinned(this);
+	if(pinned != pinned_connections.end()) {
+		//Long-lived pins (Async SQL workers) would otherwise keep a dead connection for good
+		if(pinned->transaction_depth > 0 && !_connections[pinned->slot]->is_open()) {
+			throw pqxx::broken_connection("Connection dropped during a transaction.");
+		}
+		reconnect_if_closed(pinned->slot);
+
+		return Lease(this, pinned->slot, _connections[pinned->slot].get(), false);
+	}
+
+	const std::size_t slot = checkout();
+	return Lease(this, slot, _connections[slot].get(), true);
+}
+void Connection_Pool::pin_thread(bool in_transaction) {
+	const int transaction_pin = in_transaction ? 1 : 0;
+
+	const auto pinned = find_pinned(this);
+	if(pinned != pinned_connections.end()) {
+		++pinned->depth;
+		pinned->transaction_depth += transaction_pin;
+		return;
+	}
+
+	pinned_connections.push_back({ this, checkout(), 1, transaction_pin });
+}
+void Connection_Pool::unpin_thread(bool in_transaction) {
+	const auto pinned = find_pinned(this);
+	if(pinned == pinned_connections.end()) {
+		return;
+	}
+
+	if(in_transaction) {
+		pinned->transaction_depth = std::max(pinned->transaction_depth - 1, 0);
+	}
+	if(--pinned->depth == 0) {
+		const std::size_t slot = pinned->slot;
+		pinned_connections.erase(pinned);
+		release(slot);
+	}
+}
+
+bool Connection_Pool::is_thread_pinned() const {
+	return find_pinned(this) != pinned_connections.end();
+}
+
+Connection_Pool::Stats Connection_Pool::get_stats() {
+	std::lock_guard<std::mutex> lock(_pool_mtx);
+
+	Stats res = _stats;
+	res.idle = static_cast<int>(_idle_slots.size());
+
+	return res;
+}
@@ -0,0 +1,111 @@
+#include "trackerbot/edit_scheduler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+	constexpr int64_t minute = 60;
+	constexpr int64_t hour = 60 * minute;
+	constexpr int64_t day = 24 * hour;
+}
+
+const Edit_Scheduler::Tier& Edit_Scheduler::tier_for(int64_t age) {
+	//Fresh comments are edited the most, so they're checked in minutes; week-old ones a few times a day
+	static constexpr Tier tiers[] = {
+		{ hour, 2 * minute, 10 * minute },
+		{ day, 10 * minute, hour },
+		{ 3 * day, hour, 6 * hour },
+		{ std::numeric_limits<int64_t>::max(), 6 * hour, day }
+	};
+
+	for(const Tier& tier : tiers) {
+		if(age < tier.max_age) {
+			return tier;
+		}
+	}
+	return tiers[std::size(tiers) - 1];
+}
+
+void Edit_Scheduler::begin_sync() {
+	++_generation;
+}
+void Edit_Scheduler::sync_page(const Stored_Epochs& page, int64_t now) {
+	for(const auto& [comment_id, epoch] : page) {
+		const auto itr = _entries.find(comment_id);
+		if(itr != _entries.end() && itr->second.stored_epoch == epoch) {
+			itr->second.generation = _generation;
+			continue;
+		}
+
+		//New to the schedule, or the stored epoch moved because an edit was written
+		const int64_t interval = tier_for(now - epoch).min_interval;
+		_entries[comment_id] = Entry{ epoch, _generation, epoch, interval, epoch + interval };
+	}
+}
+void Edit_Scheduler::end_sync() {
+	for(auto itr = _entries.begin(); itr != _entries.end();) {
+		itr = itr->second.generation == _generation ? std::next(itr) : _entries.erase(itr);
+	}
+}
+
+std::optional<int64_t> Edit_Scheduler::stored_epoch(const std::string& comment_id) const {
+	const auto itr = _entries.find(comment_id);
+	if(itr == _entries.end()) {
+		return std::nullopt;
+	}
+	return itr->second.stored_epoch;
+}
+std::vector<std::string> Edit_Scheduler::take_due(int64_t now, std::size_t batch_size) const {
+	std::vector<std::pair<int64_t, const std::string*>> order;
+	order.reserve(_entries.size());
+	for(const auto& [comment_id, entry] : _entries) {
+		order.emplace_back(entry.next_check, &comment_id);
+	}
+	std::sort(order.begin(), order.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+	const std::size_t due_count = static_cast<std::size_t>(std::count_if(order.begin(), order.end(),
+		[now](const auto& itr) { return itr.first <= now; }));
+	if(due_count == 0) {
+		return {};
+	}
+
+	//A partial batch costs the same request as a full one, so pull the next comments forward into it
+	batch_size = std::max<std::size_t>(batch_size, 1);
+	const std::size_t padded_count = std::min(order.size(), (due_count + batch_size - 1) / batch_size * batch_size);
+
+	std::vector<std::string> res;
+	res.reserve(padded_count);
+	for(std::size_t i = 0; i < padded_count; ++i) {
+		res.emplace_back(*order[i].second);
+	}
+
+	return res;
+}
+void Edit_Scheduler::record_check(const std::string& comment_id, int64_t now, bool edited) {
+	const auto itr = _entries.find(comment_id);
+	if(itr == _entries.end()) {
+		return;
+	}
+	Entry& entry = itr->second;
+
+	if(edited) {
+		entry.last_activity = now;
+		entry.interval = tier_for(0).min_interval;
+	}
+	else {
+		const Tier& tier = tier_for(now - entry.last_activity);
+		entry.interval = std::clamp(entry.interval * 2, tier.min_interval, tier.max_interval);
+	}
+	entry.next_check = now + entry.interval;
+}
+
+std::size_t Edit_Scheduler::size() const {
+	return _entries.size();
+}
\ No newline at end of file
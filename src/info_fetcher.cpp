@@ -0,0 +1,98 @@
+#include "trackerbot/info_fetcher.h"
+
+#include "trackerbot/rate_limiter.h"
+
+#include <redditcpp/api.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+Info_Fetcher::Info_Fetcher(std::shared_ptr<reddit::Api> api, Rate_Limiter& limiter, int max_concurrency)
+	: _reddit_api(std::move(api))
+	, _limiter(limiter)
+	, _max_concurrency(static_cast<std::size_t>(std::max(max_concurrency, 1)))
+{
+}
+
+Info_Fetcher::Result Info_Fetcher::fetch(const std::vector<std::string>& comment_ids, Rate_Limiter::Priority priority) {
+	std::vector<std::vector<std::string>> chunks;
+	std::unordered_set<std::string> requested;
+	requested.reserve(comment_ids.size());
+
+	for(const std::string& comment_id : comment_ids) {
+		if(!requested.insert(comment_id).second) {
+			continue;
+		}
+		if(chunks.empty() || chunks.back().size() == chunk_size) {
+			chunks.emplace_back();
+			chunks.back().reserve(chunk_size);
+		}
+		chunks.back().emplace_back("t1_" + comment_id);
+	}
+
+	Result res;
+	res.comments.reserve(requested.size());
+
+	std::mutex result_mtx;
+	std::exception_ptr first_error;
+	std::atomic<std::size_t> next_chunk{ 0 };
+
+	const auto drain_chunks = [&]() {
+		for(std::size_t idx = next_chunk++; idx < chunks.size(); idx = next_chunk++) {
+			try {
+				reddit::CommentListings listing = fetch_chunk(chunks[idx], priority);
+
+				std::lock_guard<std::mutex> lock(result_mtx);
+				for(auto& comment : listing.children) {
+					const std::string comment_id = comment.id;
+					res.comments.emplace(comment_id, std::move(comment));
+				}
+			}
+			catch(...) {
+				std::lock_guard<std::mutex> lock(result_mtx);
+				if(!first_error) {
+					first_error = std::current_exception();
+				}
+			}
+		}
+	};
+
+	//The calling thread takes a share too, so a single chunk never spawns a thread
+	const std::size_t helper_count = std::min(_max_concurrency, chunks.size()) - (chunks.empty() ? 0 : 1);
+	std::vector<std::future<void>> helpers;
+	helpers.reserve(helper_count);
+	for(std::size_t i = 0; i < helper_count; ++i) {
+		helpers.emplace_back(std::async(std::launch::async, drain_chunks));
+	}
+	drain_chunks();
+	for(auto& helper : helpers) {
+		helper.wait();
+	}
+
+	if(first_error) {
+		std::rethrow_exception(first_error);
+	}
+
+	for(const std::string& comment_id : requested) {
+		if(res.comments.count(comment_id) == 0) {
+			res.missing.push_back(comment_id);
+		}
+	}
+
+	return res;
+}
+
+reddit::CommentListings Info_Fetcher::fetch_chunk(const std::vector<std::string>& fullnames, Rate_Limiter::Priority priority) {
+	return _limiter.call(priority, [&]() {
+		return _reddit_api->get_comments(fullnames);
+	});
+}
\ No newline at end of file
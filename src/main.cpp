@@ -3,6 +3,7 @@
 #include "trackerbot/commands.h"
 #include "trackerbot/tracker.h"
 
+#include <cstdlib>
 #include <memory>
 #include <sstream>
 
@@ -16,6 +17,16 @@ int main() {
     dpp::cluster bot(discord_cfg.token, dpp::i_default_intents);
     Tracker tracker(&bot, std::move(cfg));
     Commands_Handler cmd_handler(&bot, &tracker);
+    //The gateway connects while SQL & Reddit warm up; interactions are turned away until then
+    tracker.begin_startup();
+
+    auto starting_up = [&tracker](const dpp::interaction_create_t& event) {
+        if(tracker.is_ready()) {
+            return false;
+        }
+        event.reply(dpp::message("Tracker is still starting up, try again shortly.").set_flags(dpp::m_ephemeral));
+        return true;
+    };
 
     bot.on_ready([&bot, &tracker, target_guild](const dpp::ready_t& event) {
         std::cout << "Logged in as " << bot.me.username << "!\n";
@@ -24,8 +35,13 @@ int main() {
             dpp::slashcommand debug_cmd("debug", "Debug Menu", bot.me.id);
             bot.guild_command_create_sync(debug_cmd, target_guild);
             
-            tracker.tracker_thread_initiate();
-            std::cout << "Tracker Started\n";
+            std::thread([&tracker]() {
+                if(!tracker.wait_until_ready()) {
+                    std::exit(EXIT_FAILURE);
+                }
+                tracker.tracker_thread_initiate();
+                std::cout << "Tracker Started\n";
+            }).detach();
         }
     });
 
@@ -35,13 +51,19 @@ int main() {
         }
     });
 
-    bot.on_interaction_create([&cmd_handler](const dpp::interaction_create_t& event) {
+    bot.on_interaction_create([&cmd_handler, &starting_up](const dpp::interaction_create_t& event) {
+        if(starting_up(event)) {
+            return;
+        }
         const std::string command = event.command.get_command_name();
 
         cmd_handler.interact(command, event);
     });
 
-    bot.on_button_click([&cmd_handler, &tracker](const dpp::button_click_t& event) {
+    bot.on_button_click([&cmd_handler, &tracker, &starting_up](const dpp::button_click_t& event) {
+        if(starting_up(event)) {
+            return;
+        }
         if(!tracker.permissions_check(event, User::Permission::MANAGEMENT)) {
             return;
         }
@@ -55,7 +77,10 @@ int main() {
         cmd_handler.btnclick(command, event, arg);
     });
 
-    bot.on_select_click([&bot, &tracker](const dpp::select_click_t& event) {
+    bot.on_select_click([&bot, &tracker, &starting_up](const dpp::select_click_t& event) {
+        if(starting_up(event)) {
+            return;
+        }
         std::stringstream ss(event.custom_id);
         std::string command;
         ss >> command;
@@ -92,7 +117,10 @@ int main() {
         }
     });
 
-    bot.on_form_submit([&bot, &tracker](const dpp::form_submit_t& event) {
+    bot.on_form_submit([&bot, &tracker, &starting_up](const dpp::form_submit_t& event) {
+        if(starting_up(event)) {
+            return;
+        }
         std::stringstream ss(event.custom_id);
         std::string command;
         ss >> command;
@@ -137,7 +165,6 @@ int main() {
 
             for(int i = 0; i < targets.size(); ++i) {
                 bool suspend_result = tracker.suspend_target(event, targets[i]);
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
                 if(!suspend_result) {
                     failed += format(targets[i]);
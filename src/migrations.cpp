@@ -0,0 +1,90 @@
+#include "trackerbot/migrations.h"
+
+#include <string>
+#include <vector>
+
+const std::vector<Schema_Migration>& schema_migrations() {
+	static const std::vector<Schema_Migration> migrations = {
+		{ 1, "dev_stats counters & trigger", {
+			//Holds off comment writes until the trigger is live & the backfill has been counted
+			"LOCK TABLE {0}.comments IN SHARE ROW EXCLUSIVE MODE;",
+			//Per-dev counts are keyed by LOWER(Dev_Username); the '' row carries the totals across all devs
+			"CREATE TABLE IF NOT EXISTS {0}.dev_stats ( \
+				Dev_Key TEXT PRIMARY KEY, \
+				Total INTEGER NOT NULL DEFAULT 0, \
+				Pinned INTEGER NOT NULL DEFAULT 0 \
+			);",
+			"CREATE OR REPLACE FUNCTION {0}.dev_stats_sync() RETURNS TRIGGER AS $$ \
+			BEGIN \
+				IF TG_OP <> 'INSERT' THEN \
+					UPDATE {0}.dev_stats SET Total = Total - 1, Pinned = Pinned - (OLD.Status = 1)::INTEGER \
+					WHERE Dev_Key IN (LOWER(OLD.Dev_Username), ''); \
+				END IF; \
+				IF TG_OP <> 'DELETE' THEN \
+					INSERT INTO {0}.dev_stats AS s (Dev_Key, Total, Pinned) \
+					VALUES (LOWER(NEW.Dev_Username), 1, (NEW.Status = 1)::INTEGER), ('', 1, (NEW.Status = 1)::INTEGER) \
+					ON CONFLICT (Dev_Key) DO UPDATE SET Total = s.Total + EXCLUDED.Total, Pinned = s.Pinned + EXCLUDED.Pinned; \
+				END IF; \
+				RETURN NULL; \
+			END; \
+			$$ LANGUAGE plpgsql;",
+			"DROP TRIGGER IF EXISTS dev_stats_sync ON {0}.comments;",
+			"CREATE TRIGGER dev_stats_sync AFTER INSERT OR DELETE OR UPDATE OF Status, Dev_Username ON {0}.comments \
+				FOR EACH ROW EXECUTE PROCEDURE {0}.dev_stats_sync();",
+			//Only backfills an empty table - deployments that already built dev_stats keep their counts
+			"INSERT INTO {0}.dev_stats (Dev_Key, Total, Pinned) \
+				SELECT * FROM ( \
+					SELECT LOWER(Dev_Username), COUNT(*), COUNT(*) FILTER (WHERE Status = 1) FROM {0}.comments GROUP BY 1 \
+					UNION ALL \
+					SELECT '', COUNT(*), COUNT(*) FILTER (WHERE Status = 1) FROM {0}.comments \
+				) AS counts WHERE NOT EXISTS (SELECT 1 FROM {0}.dev_stats);"
+		} },
+		{ 2, "indexes for the hot read paths", {
+			//Approved comments of a thread, newest first - sticky renders & per-thread update checks
+			"CREATE INDEX IF NOT EXISTS comments_thread_approved_idx ON {0}.comments (Thread_ID, Post_Epoch DESC) WHERE Status = 1;",
+			//Approved comments within the update day window
+			"CREATE INDEX IF NOT EXISTS comments_approved_timestamp_idx ON {0}.comments (Timestamp) WHERE Status = 1;",
+			"CREATE INDEX IF NOT EXISTS contexts_owner_active_idx ON {0}.contexts (Owner_Comment_ID) WHERE Status = true;",
+			"CREATE INDEX IF NOT EXISTS contexts_thread_active_idx ON {0}.contexts (Thread_ID) WHERE Status = true;"
+		} },
+		{ 3, "keyset pagination indexes", {
+			//Day-window walks resume from the last (Post_Epoch, Comment_ID) / (Timestamp, Thread_ID) seen
+			"CREATE INDEX IF NOT EXISTS comments_approved_keyset_idx ON {0}.comments (Post_Epoch DESC, Comment_ID DESC) WHERE Status = 1;",
+			"CREATE INDEX IF NOT EXISTS threads_timestamp_keyset_idx ON {0}.threads (Timestamp DESC, Thread_ID DESC);"
+		} },
+		{ 4, "cold archive tables for comments & contexts", {
+			//Same columns, keys & indexes as the hot tables, so rows move across with INSERT ... SELECT *
+			"CREATE TABLE IF NOT EXISTS {0}.comments_archive (LIKE {0}.comments INCLUDING ALL);",
+			"CREATE TABLE IF NOT EXISTS {0}.contexts_archive (LIKE {0}.contexts INCLUDING ALL);",
+			//Archived rows still count towards dev_stats - a move is a -1 on comments & a +1 here
+			"DROP TRIGGER IF EXISTS dev_stats_sync ON {0}.comments_archive;",
+			"CREATE TRIGGER dev_stats_sync AFTER INSERT OR DELETE OR UPDATE OF Status, Dev_Username ON {0}.comments_archive \
+				FOR EACH ROW EXECUTE PROCEDURE {0}.dev_stats_sync();"
+		} },
+		{ 5, "tracker state for persisted poll cursors", {
+			"CREATE TABLE IF NOT EXISTS {0}.tracker_state ( \
+				State_Key TEXT PRIMARY KEY, \
+				State_Value TEXT NOT NULL, \
+				Updated_At TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP \
+			);"
+		} },
+		{ 6, "digest of the last published sticky body", {
+			"ALTER TABLE {0}.threads ADD COLUMN IF NOT EXISTS Body_Digest BIGINT;"
+		} },
+		{ 7, "original creation epoch of each comment", {
+			//Post_Epoch moves with every edit; added to both tables so SELECT * still lines up across the archive
+			"ALTER TABLE {0}.comments ADD COLUMN IF NOT EXISTS Created_Epoch BIGINT;",
+			"ALTER TABLE {0}.comments_archive ADD COLUMN IF NOT EXISTS Created_Epoch BIGINT;"
+		} },
+		{ 8, "pending approvals", {
+			//Written with the comment & cleared once dispatched, so approvals queued in memory survive a restart
+			"CREATE TABLE IF NOT EXISTS {0}.pending_approvals ( \
+				Comment_ID TEXT PRIMARY KEY, \
+				Status SMALLINT NOT NULL, \
+				Queued_At TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP \
+			);"
+		} }
+	};
+
+	return migrations;
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "trackerbot/rate_limiter.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <string>
+
+Rate_Limiter::Rate_Limiter(double requests_per_minute, int burst)
+	: _max_rate(std::max(requests_per_minute, 1.0) / 60.0)
+	, _rate(_max_rate)
+	, _burst(std::max(burst, 1))
+	, _tokens(_burst)
+	, _last_refill(Clock::now())
+	, _paused_until(_last_refill)
+{
+}
+
+void Rate_Limiter::acquire(Priority priority) {
+	const std::size_t lane = static_cast<std::size_t>(priority);
+
+	std::unique_lock<std::mutex> lock(_limiter_mtx);
+	++_waiting[lane];
+
+	while(true) {
+		const Clock::time_point now = Clock::now();
+		refill(now);
+
+		//A higher lane takes the next token first & wakes everyone once it has
+		if(higher_lane_waiting(priority)) {
+			_limiter_cv.wait(lock);
+			continue;
+		}
+		if(now >= _paused_until && _tokens >= 1.0) {
+			break;
+		}
+
+		const std::chrono::duration<double> until_token{ (1.0 - _tokens) / _rate };
+		const Clock::time_point wake = std::max(_paused_until, now + std::chrono::duration_cast<Clock::duration>(until_token));
+		_limiter_cv.wait_until(lock, wake);
+	}
+
+	--_waiting[lane];
+	_tokens -= 1.0;
+	lock.unlock();
+
+	_limiter_cv.notify_all();
+}
+void Rate_Limiter::report_success() {
+	std::lock_guard<std::mutex> lock(_limiter_mtx);
+	_rate = std::min(_max_rate, _rate + _max_rate * recovery_fraction);
+}
+void Rate_Limiter::report_throttled() {
+	{
+		std::lock_guard<std::mutex> lock(_limiter_mtx);
+		refill(Clock::now());
+
+		_rate = std::max(_max_rate * min_rate_fraction, _rate / 2.0);
+		_tokens = 0.0;
+		_paused_until = Clock::now() + throttle_pause;
+
+		spdlog::warn("Reddit: Rate limited, backing off to {:.1f} requests/min", _rate * 60.0);
+	}
+	_limiter_cv.notify_all();
+}
+
+double Rate_Limiter::requests_per_minute() {
+	std::lock_guard<std::mutex> lock(_limiter_mtx);
+	return _rate * 60.0;
+}
+
+void Rate_Limiter::refill(Clock::time_point now) {
+	const std::chrono::duration<double> elapsed = now - _last_refill;
+	_tokens = std::min(_burst, _tokens + elapsed.count() * _rate);
+	_last_refill = now;
+}
+bool Rate_Limiter::higher_lane_waiting(Priority priority) const {
+	for(std::size_t lane = 0; lane < static_cast<std::size_t>(priority); ++lane) {
+		if(_waiting[lane] > 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+bool Rate_Limiter::is_throttle_error(const std::exception& e) {
+	//The Reddit client only surfaces failures as exception text - no status field & no X-Ratelimit headers -
+	//so the status code & Reddit's RATELIMIT error code are matched as whole tokens, never inside an ID or longer number
+	const std::string message = e.what();
+	return contains_token(message, "429") || contains_token(message, "RATELIMIT");
+}
+bool Rate_Limiter::contains_token(const std::string& message, const std::string& token) {
+	auto is_word_char = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+
+	for(std::size_t pos = message.find(token); pos != std::string::npos; pos = message.find(token, pos + 1)) {
+		const bool starts_word = pos == 0 || !is_word_char(message[pos - 1]);
+		const std::size_t end = pos + token.size();
+		const bool ends_word = end == message.size() || !is_word_char(message[end]);
+		if(starts_word && ends_word) {
+			return true;
+		}
+	}
+
+	return false;
+}
\ No newline at end of file
@@ -1,104 +1,354 @@
 #include "trackerbot/sql.h"
 
+#include "trackerbot/connection_pool.h"
+#include "trackerbot/migrations.h"
 #include "trackerbot/types.h"
+#include "trackerbot/update_listener.h"
+#include "trackerbot/username_interner.h"
+#include "trackerbot/utility.h"
 
 #include <pqxx/pqxx>
 #include <spdlog/spdlog.h>
 
-#include <mutex> 
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
-sql_handler::sql_handler(std::string subreddit, std::string admin_credentials, std::string conn_string) 
+namespace {
+	//Comments inserted inside a begin_transaction span stay out of the seen-index until the COMMIT lands
+	thread_local std::vector<std::string> uncommitted_comment_ids;
+	//Likewise for the in-memory dev counts, so a rollback never leaves them ahead of dev_stats
+	struct Dev_Stats_Delta {
+		Username_Interner::Id dev;
+		int total_delta;
+		int pinned_delta;
+	};
+	thread_local std::vector<Dev_Stats_Delta> uncommitted_dev_stats;
+	//Thread cache entries touched inside the span - dropping them before COMMIT would let a reader
+	//on another connection re-cache the pre-commit rows
+	thread_local std::vector<std::string> uncommitted_thread_ids;
+	thread_local int transaction_depth = 0;
+}
+
+namespace {
+	//Compile-time parameter & result column types of a prepared statement
+	template<typename... T> struct Params {};
+	template<typename... T> struct Columns {};
+	using Opt_Text = std::optional<std::string>;
+
+	template<typename P, typename C> struct Signature {
+		using params = P;
+		using columns = C;
+	};
+
+	//Integer parameters go out in binary (network byte order) - the statement text casts them to the matching width
+	template<typename T>
+	pqxx::bytes to_network_bytes(T value) {
+		using Unsigned = std::make_unsigned_t<T>;
+		Unsigned bits = static_cast<Unsigned>(value);
+
+		pqxx::bytes res(sizeof(T), std::byte{ 0 });
+		for(std::size_t i = sizeof(T); i > 0; --i) {
+			res[i - 1] = static_cast<std::byte>(bits & 0xFF);
+			bits = static_cast<Unsigned>(bits >> 8);
+		}
+
+		return res;
+	}
+	template<typename P, typename A>
+	void append_param(pqxx::params& params, const A& arg) {
+		static_assert(std::is_convertible_v<A, P> || std::is_enum_v<A>, "Argument does not match the statement's parameter type");
+
+		if constexpr(std::is_integral_v<P> && !std::is_same_v<P, bool>) {
+			params.append(to_network_bytes(static_cast<P>(arg)));
+		}
+		else if constexpr(std::is_same_v<P, std::string>) {
+			params.append(std::string_view{ arg });
+		}
+		else {
+			params.append(static_cast<P>(arg));
+		}
+	}
+}
+
+struct sql_handler::Statement_Registry {
+	struct Statement {
+		Prepareds id;
+		const char* name;
+		const char* sql;
+	};
+
+	//Indexed by Prepareds - integer parameters carry an explicit cast so the server expects the binary width we send
+	static constexpr Statement table[] = {
+		{ Prepareds::GET_TOTAL_PINNED,				"Get_Total_Pinned",		  	"SELECT COALESCE(SUM(Total), 0), COALESCE(SUM(Pinned), 0) FROM dev_stats WHERE Dev_Key = '';" },
+		{ Prepareds::GET_DEV_RATIO,					"Get_Dev_Ratio",			"SELECT COALESCE(SUM(Total) FILTER (WHERE Dev_Key = ''), 0) AS all_total, \
+																						COALESCE(SUM(Pinned) FILTER (WHERE Dev_Key = ''), 0) AS all_pinned, \
+																						COALESCE(SUM(Total) FILTER (WHERE Dev_Key = LOWER($1)), 0) AS dev_total, \
+																						COALESCE(SUM(Pinned) FILTER (WHERE Dev_Key = LOWER($1)), 0) AS dev_pinned \
+																					FROM dev_stats WHERE Dev_Key IN ('', LOWER($1));" },
+		{ Prepareds::INSERT_THREAD,			    	"Insert_Thread",            "INSERT INTO threads(Thread_ID, Sticky_ID, Body_Digest) VALUES($1, $2, $3::BIGINT);" },
+		{ Prepareds::DELETE_THREAD,					"Delete_Thread",            "DELETE FROM threads WHERE Thread_ID = $1;" },
+		{ Prepareds::GET_THREAD_ID,					"Get_Thread_ID",            "SELECT Thread_ID FROM comments WHERE Comment_ID = $1 LIMIT 1;" },
+		{ Prepareds::SET_THREAD_DIGEST,             "Set_Thread_Digest",        "UPDATE threads SET Body_Digest = $2::BIGINT WHERE Thread_ID = $1;" },
+
+		//A new comment in an archived thread pulls the rest of the thread back into the hot tables first
+		{ Prepareds::INSERT_COMMENT,				"Insert_Comment",	        "WITH restored_contexts AS (DELETE FROM contexts_archive WHERE Thread_ID = $2 RETURNING *), \
+																				 back_contexts AS (INSERT INTO contexts SELECT * FROM restored_contexts), \
+																				 restored AS (DELETE FROM comments_archive WHERE Thread_ID = $2 RETURNING *), \
+																				 back AS (INSERT INTO comments SELECT * FROM restored) \
+																				 INSERT INTO comments \
+																				 (Comment_ID, Thread_ID, Dev_Username, Status, Supervisor_Username, Supervisor_ID, Post_Epoch, Created_Epoch, Comment_Text) \
+																				 VALUES ($1, $2, $3, $4::SMALLINT, $5, $6::BIGINT, $7::BIGINT, $8::BIGINT, $9);" },
+		{ Prepareds::UPDATE_COMMENT,				"Update_Comment",			"UPDATE comments SET Comment_Text = $1, Post_Epoch = $2::BIGINT WHERE Comment_ID = $3 AND Post_Epoch < $2::BIGINT RETURNING Thread_ID;" },
+		{ Prepareds::CHANGE_COMMENT_STATUS,			"Change_Comment_Status",	"UPDATE comments AS c SET Timestamp = CURRENT_TIMESTAMP, Status = $1::SMALLINT, Supervisor_Username = $2, Supervisor_ID = $3::BIGINT \
+																				 FROM (SELECT Comment_ID, Status FROM comments WHERE Comment_ID = $4 FOR UPDATE) AS o \
+																				 WHERE c.Comment_ID = o.Comment_ID RETURNING c.Thread_ID, c.Dev_Username, o.Status, COALESCE(c.Created_Epoch, c.Post_Epoch), c.Comment_Text;" },
+		{ Prepareds::GET_COMMENT_STATUS,			"Get_Comment_Status",		"SELECT status FROM comments WHERE comment_id = $1;" },
+		{ Prepareds::DELETE_COMMENT, 				"Delete_Comment",			"DELETE FROM comments WHERE Comment_ID = $1 RETURNING Dev_Username, Status, Thread_ID;" },
+
+		{ Prepareds::INSERT_CONTEXT, 				"Insert_Context",			"INSERT INTO contexts(Context_ID, Thread_ID, Owner_Comment_ID, Status, Comment_Text) VALUES ($1, $2, $3, $4, $5);" },
+		{ Prepareds::GET_CONTEXT, 					"Get_Context",			  	"SELECT Comment_Text FROM contexts WHERE Owner_Comment_ID = $1 AND Status = true LIMIT 1;" },
+		{ Prepareds::GET_CONTEXTS_BY_THREAD, 		"Get_Context_By_Thread",	"SELECT Owner_Comment_ID, Comment_Text FROM contexts WHERE thread_id = $1 AND Status = true;" },
+
+		//Notifies even when the thread is already queued - it may be mid-publish, about to be dequeued with this change unseen
+		{ Prepareds::ENQUEUE_UPDATE,				"Enqueue_Update",			"WITH q AS (INSERT INTO update_queue (Thread_ID) VALUES ($1) ON CONFLICT DO NOTHING) \
+																				 SELECT pg_notify(LOWER(current_schema()) || '_update_queue', $1);" },
+		{ Prepareds::DEQUEUE_UPDATE,				"Dequeue_Update",			"DELETE FROM update_queue WHERE Thread_ID = $1;" },
+		{ Prepareds::UPDATE_QUEUE_SIZE,         	"Update_Queue_Size",		"SELECT FROM update_queue WHERE Thread_ID = $1;" },
+		{ Prepareds::GET_UPDATE_QUEUE,          	"Get_Update_Queue",		  	"SELECT Thread_ID FROM update_queue;" },
+
+		{ Prepareds::UPSERT_DEV,                	"Upsert_Dev",				"INSERT INTO devs(Dev_Username, Expertise, Status, Supervisor_Username, Supervisor_ID, \
+																				 Last_Modifier_Username, Last_Modifier_ID) \
+																				 VALUES ($1, $2, $3::SMALLINT, $4, $5::BIGINT, $4, $5::BIGINT) \
+																				 ON CONFLICT (Dev_Username) DO UPDATE \
+																				 SET Status = $3::SMALLINT, Last_Modifier_Username = $4, Last_Modifier_ID = $5::BIGINT, Last_Modified = CURRENT_TIMESTAMP;" },
+		{ Prepareds::UPDATE_DEV_STATUS,         	"Update_Dev_Status",		"UPDATE devs SET Status = $1::SMALLINT, Last_Modifier_Username = $2, Last_Modifier_ID = $3::BIGINT, Last_Modified = CURRENT_TIMESTAMP \
+																		 		 WHERE Dev_Username = $4;" },
+		{ Prepareds::UPDATE_DEV_EXPERTISE,      	"Update_Dev_Expertise",	  	"UPDATE devs SET Expertise = $1, Last_Modifier_Username = $2, Last_Modifier_ID = $3::BIGINT, Last_Modified = CURRENT_TIMESTAMP \
+																				 WHERE Dev_Username = $4;" },
+		{ Prepareds::DELETE_DEV_EXPERTISE,			"Delete_Dev_Expertise",	  	"UPDATE devs SET Expertise = '', Last_Modifier_Username = $1, Last_Modifier_ID = $2::BIGINT, Last_Modified = CURRENT_TIMESTAMP \
+																				 WHERE Dev_Username = $3;" },
+
+		{ Prepareds::INSERT_DEVEDIT_SESSION,    	"Insert_DevEdit_Session",	"INSERT INTO devedit_sessions(dev_username, managing_msg, msg_channel) \
+																				 VALUES($1, $2::BIGINT, $3::BIGINT);" },
+		{ Prepareds::DELETE_DEVEDIT_SESSION,    	"Delete_DevEdit_Session",	"DELETE FROM devedit_sessions WHERE dev_username = $1;" },
+
+		{ Prepareds::GET_STICKY_ID,                 "Get_Sticky_ID",			"SELECT Sticky_ID FROM threads WHERE Thread_ID = $1 LIMIT 1;" },
+
+		{ Prepareds::CHECK_COMMENT_EXIST,           "Check_Comment_Exist",	  	"SELECT EXISTS(SELECT 1 FROM comments WHERE comment_id = $1) \
+																				 OR EXISTS(SELECT 1 FROM comments_archive WHERE Comment_ID = $1);" },
+		{ Prepareds::GET_OTHER_COMMENTS,            "Get_Other_Comments",		"SELECT Comment_ID, Thread_ID, Dev_Username, Post_Epoch, Comment_Text FROM comments WHERE Thread_ID = $1 AND Status = 1 \
+																				 ORDER BY Post_Epoch DESC;" },
+		{ Prepareds::GET_THREAD_SNAPSHOT,           "Get_Thread_Snapshot",	  	"SELECT t.Sticky_ID, c.Comment_ID, c.Dev_Username, c.Post_Epoch, c.Comment_Text, x.Comment_Text, t.Body_Digest \
+																				 FROM (SELECT 1) AS q \
+																				 LEFT JOIN threads AS t ON t.Thread_ID = $1 \
+																				 LEFT JOIN comments AS c ON c.Thread_ID = $1 AND c.Status = 1 \
+																				 LEFT JOIN LATERAL (SELECT Comment_Text FROM contexts WHERE Owner_Comment_ID = c.Comment_ID AND Status = true LIMIT 1) AS x ON true \
+																				 ORDER BY c.Post_Epoch DESC;" },
+
+		{ Prepareds::THREAD_ID_PAGE_BY_DATE,        "Thread_ID_Page_By_Date",   "SELECT Thread_ID, Timestamp::TEXT FROM threads WHERE Timestamp > CURRENT_DATE - $1::SMALLINT \
+																				 AND (Timestamp, Thread_ID) < ($2::TIMESTAMPTZ, $3) ORDER BY Timestamp DESC, Thread_ID DESC LIMIT $4::INTEGER;" },
+		{ Prepareds::COMMENT_EPOCH_PAGE_BY_DATE,    "Comment_Epoch_Page_By_Date", "SELECT Comment_ID, Post_Epoch FROM comments WHERE Status = 1 AND Timestamp > CURRENT_DATE - $1::SMALLINT \
+																				 AND (Post_Epoch, Comment_ID) < ($2::BIGINT, $3) ORDER BY Post_Epoch DESC, Comment_ID DESC LIMIT $4::INTEGER;" },
+		{ Prepareds::GET_COMMENT_IDS_BY_THREAD,     "Comments_By_Thread",	    "SELECT Comment_ID FROM comments WHERE Thread_ID = $1 AND Status = 1 ORDER BY Post_Epoch DESC;" },
+		{ Prepareds::COMMENT_EPOCH_PAIRS_BY_THREAD, "Comment_Epochs_By_Thread", "SELECT Comment_ID, Post_Epoch FROM comments WHERE thread_id = $1 AND STATUS = 1 ORDER BY Post_Epoch DESC;" },
+		{ Prepareds::COMMENT_ID_PAGE,               "Comment_ID_Page",          "SELECT Comment_ID, Post_Epoch > EXTRACT(EPOCH FROM CURRENT_DATE - $1::SMALLINT) FROM comments \
+																				 WHERE Comment_ID > $2 ORDER BY Comment_ID LIMIT $3::INTEGER;" },
+
+		//Threads move as a whole, so a hot thread never has comments in the archive; queued threads wait for their update
+		{ Prepareds::ARCHIVE_COLD_THREADS,          "Archive_Cold_Threads",     "WITH cold AS (SELECT c.Thread_ID FROM comments AS c \
+																				 	WHERE NOT EXISTS (SELECT 1 FROM update_queue AS q WHERE q.Thread_ID = c.Thread_ID) \
+																				 	GROUP BY c.Thread_ID HAVING MAX(c.Timestamp) < CURRENT_DATE - $1::SMALLINT), \
+																				 moved_contexts AS (DELETE FROM contexts AS x USING cold WHERE x.Thread_ID = cold.Thread_ID RETURNING x.*), \
+																				 archived_contexts AS (INSERT INTO contexts_archive SELECT * FROM moved_contexts RETURNING 1), \
+																				 moved AS (DELETE FROM comments AS c USING cold WHERE c.Thread_ID = cold.Thread_ID RETURNING c.*), \
+																				 archived AS (INSERT INTO comments_archive SELECT * FROM moved RETURNING 1) \
+																				 SELECT (SELECT COUNT(*) FROM archived), (SELECT COUNT(*) FROM archived_contexts);" },
+		{ Prepareds::DROP_ORPHAN_CONTEXTS,          "Drop_Orphan_Contexts",     "DELETE FROM contexts AS x WHERE NOT EXISTS (SELECT 1 FROM comments AS c WHERE c.Comment_ID = x.Owner_Comment_ID);" },
+		{ Prepareds::RESTORE_THREAD,                "Restore_Thread",           "WITH restored_contexts AS (DELETE FROM contexts_archive WHERE Thread_ID = $1 RETURNING *), \
+																				 back_contexts AS (INSERT INTO contexts SELECT * FROM restored_contexts), \
+																				 restored AS (DELETE FROM comments_archive WHERE Thread_ID = $1 RETURNING *) \
+																				 INSERT INTO comments SELECT * FROM restored;" },
+		{ Prepareds::GET_ARCHIVED_THREAD_ID,        "Get_Archived_Thread_ID",   "SELECT Thread_ID FROM comments_archive WHERE Comment_ID = $1 LIMIT 1;" },
+		{ Prepareds::ARCHIVED_COMMENT_ID_PAGE,      "Archived_Comment_ID_Page", "SELECT Comment_ID FROM comments_archive WHERE Comment_ID > $1 ORDER BY Comment_ID LIMIT $2::INTEGER;" },
+
+		{ Prepareds::GET_TRACKER_STATE,             "Get_Tracker_State",        "SELECT State_Value FROM tracker_state WHERE State_Key = $1;" },
+		{ Prepareds::SET_TRACKER_STATE,             "Set_Tracker_State",        "INSERT INTO tracker_state(State_Key, State_Value) VALUES($1, $2) \
+																				 ON CONFLICT (State_Key) DO UPDATE SET State_Value = EXCLUDED.State_Value, Updated_At = CURRENT_TIMESTAMP;" },
+
+		{ Prepareds::INSERT_PENDING_APPROVAL,       "Insert_Pending_Approval",  "INSERT INTO pending_approvals(Comment_ID, Status) VALUES($1, $2::SMALLINT) ON CONFLICT (Comment_ID) DO NOTHING;" },
+		{ Prepareds::DELETE_PENDING_APPROVAL,       "Delete_Pending_Approval",  "DELETE FROM pending_approvals WHERE Comment_ID = $1;" },
+		{ Prepareds::GET_PENDING_APPROVALS,         "Get_Pending_Approvals",    "WITH orphaned AS (DELETE FROM pending_approvals AS p WHERE NOT EXISTS (SELECT 1 FROM comments AS c WHERE c.Comment_ID = p.Comment_ID)) \
+																				 SELECT p.Comment_ID, p.Status, c.Thread_ID, c.Dev_Username, COALESCE(c.Created_Epoch, c.Post_Epoch), c.Comment_Text \
+																				 FROM pending_approvals AS p JOIN comments AS c ON c.Comment_ID = p.Comment_ID ORDER BY p.Queued_At, p.Comment_ID;" }
+	};
+
+	static constexpr bool in_enum_order() {
+		for(std::size_t i = 0; i < std::size(table); ++i) {
+			if(static_cast<std::size_t>(table[i].id) != i) {
+				return false;
+			}
+		}
+		return std::size(table) == static_cast<std::size_t>(Prepareds::STATEMENT_COUNT);
+	}
+	static constexpr const Statement& get(Prepareds id) {
+		return table[static_cast<std::size_t>(id)];
+	}
+
+	template<Prepareds Id> struct Types;
+
+	template<Prepareds Id, typename... Args>
+	static pqxx::result exec(pqxx::transaction_base& txn, const Args&... args) {
+		return exec_typed(txn, get(Id).name, typename Types<Id>::params{}, args...);
+	}
+	//Columns are parsed straight from the row into their declared types
+	template<Prepareds Id>
+	static auto read(const pqxx::row& row) {
+		return read_typed(row, typename Types<Id>::columns{}, std::make_index_sequence<column_count(typename Types<Id>::columns{})>{});
+	}
+	//Aggregate-initialises Struct from the columns, in select order
+	template<typename Struct, Prepareds Id>
+	static Struct decode(const pqxx::row& row) {
+		return std::apply([](auto&&... values) {
+			return Struct{ std::move(values)... };
+		}, read<Id>(row));
+	}
+
+private:
+	template<typename... P, typename... A>
+	static pqxx::result exec_typed(pqxx::transaction_base& txn, const char* name, Params<P...>, const A&... args) {
+		static_assert(sizeof...(P) == sizeof...(A), "Wrong number of arguments for prepared statement");
+
+		pqxx::params params;
+		params.reserve(sizeof...(P));
+		(append_param<P>(params, args), ...);
+
+		return txn.exec_prepared(name, params);
+	}
+	template<typename... C>
+	static constexpr std::size_t column_count(Columns<C...>) {
+		return sizeof...(C);
+	}
+	template<typename... C, std::size_t... I>
+	static std::tuple<C...> read_typed(const pqxx::row& row, Columns<C...>, std::index_sequence<I...>) {
+		return std::tuple<C...>{ row[static_cast<int>(I)].template as<C>()... };
+	}
+};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_TOTAL_PINNED> : Signature<Params<>, Columns<int, int>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_DEV_RATIO> : Signature<Params<std::string>, Columns<int, int, int, int>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::INSERT_THREAD> : Signature<Params<std::string, std::string, int64_t>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::DELETE_THREAD> : Signature<Params<std::string>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_THREAD_ID> : Signature<Params<std::string>, Columns<std::string>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::SET_THREAD_DIGEST> : Signature<Params<std::string, int64_t>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::INSERT_COMMENT> 
+	: Signature<Params<std::string, std::string, std::string, int16_t, std::string, int64_t, int64_t, int64_t, std::string>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::UPDATE_COMMENT> : Signature<Params<std::string, int64_t, std::string>, Columns<std::string>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::CHANGE_COMMENT_STATUS> 
+	: Signature<Params<int16_t, std::string, int64_t, std::string>, Columns<std::string, std::string, int, int64_t, std::string>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_COMMENT_STATUS> : Signature<Params<std::string>, Columns<bool>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::DELETE_COMMENT> : Signature<Params<std::string>, Columns<std::string, int, std::string>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::INSERT_CONTEXT> 
+	: Signature<Params<std::string, std::string, std::string, bool, std::string>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_CONTEXT> : Signature<Params<std::string>, Columns<std::string>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_CONTEXTS_BY_THREAD> : Signature<Params<std::string>, Columns<std::string, std::string>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::ENQUEUE_UPDATE> : Signature<Params<std::string>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::DEQUEUE_UPDATE> : Signature<Params<std::string>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::UPDATE_QUEUE_SIZE> : Signature<Params<std::string>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_UPDATE_QUEUE> : Signature<Params<>, Columns<std::string>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::UPSERT_DEV> 
+	: Signature<Params<std::string, std::string, int16_t, std::string, int64_t>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::UPDATE_DEV_STATUS> : Signature<Params<int16_t, std::string, int64_t, std::string>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::UPDATE_DEV_EXPERTISE> : Signature<Params<std::string, std::string, int64_t, std::string>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::DELETE_DEV_EXPERTISE> : Signature<Params<std::string, int64_t, std::string>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::INSERT_DEVEDIT_SESSION> : Signature<Params<std::string, int64_t, int64_t>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::DELETE_DEVEDIT_SESSION> : Signature<Params<std::string>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_STICKY_ID> : Signature<Params<std::string>, Columns<std::string>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::CHECK_COMMENT_EXIST> : Signature<Params<std::string>, Columns<bool>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_OTHER_COMMENTS> 
+	: Signature<Params<std::string>, Columns<std::string, std::string, std::string, int64_t, std::string>> {};
+//Every column is NULL for a thread with no approved comments (and Sticky_ID for one without a sticky)
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_THREAD_SNAPSHOT> 
+	: Signature<Params<std::string>, Columns<Opt_Text, Opt_Text, Opt_Text, std::optional<int64_t>, Opt_Text, Opt_Text, std::optional<int64_t>>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::THREAD_ID_PAGE_BY_DATE> 
+	: Signature<Params<int16_t, std::string, std::string, int32_t>, Columns<std::string, std::string>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::COMMENT_EPOCH_PAGE_BY_DATE> 
+	: Signature<Params<int16_t, int64_t, std::string, int32_t>, Columns<std::string, int64_t>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_COMMENT_IDS_BY_THREAD> : Signature<Params<std::string>, Columns<std::string>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::COMMENT_EPOCH_PAIRS_BY_THREAD> : Signature<Params<std::string>, Columns<std::string, int64_t>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::COMMENT_ID_PAGE> : Signature<Params<int16_t, std::string, int32_t>, Columns<std::string, bool>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::ARCHIVE_COLD_THREADS> : Signature<Params<int16_t>, Columns<int, int>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::DROP_ORPHAN_CONTEXTS> : Signature<Params<>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::RESTORE_THREAD> : Signature<Params<std::string>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_ARCHIVED_THREAD_ID> : Signature<Params<std::string>, Columns<std::string>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::ARCHIVED_COMMENT_ID_PAGE> : Signature<Params<std::string, int32_t>, Columns<std::string>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_TRACKER_STATE> : Signature<Params<std::string>, Columns<std::string>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::SET_TRACKER_STATE> : Signature<Params<std::string, std::string>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::INSERT_PENDING_APPROVAL> : Signature<Params<std::string, int16_t>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::DELETE_PENDING_APPROVAL> : Signature<Params<std::string>, Columns<>> {};
+template<> struct sql_handler::Statement_Registry::Types<sql_handler::Prepareds::GET_PENDING_APPROVALS> 
+	: Signature<Params<>, Columns<std::string, int, std::string, std::string, int64_t, std::string>> {};
+
+sql_handler::sql_handler(std::string subreddit, std::string admin_credentials, std::string conn_string, int pool_size, Startup_Timer* timer) 
 	: _target_subreddit(std::move(subreddit))
 	, _admin_login_string(std::move(admin_credentials))
 	, _connection_string(std::move(conn_string))
+	, _update_channel(Utility::get_lowercase(_target_subreddit) + "_update_queue")
 {
-	if(!admin_check_setup_status()) {
+	static_assert(Statement_Registry::in_enum_order(), "Statement table must list every Prepareds value in declaration order");
+
+	Startup_Timer local_timer;
+	Startup_Timer& phases = timer ? *timer : local_timer;
+
+	//The admin check & the schema check use different logins and don't depend on each other
+	std::future<bool> setup_status = std::async(std::launch::async, [this, &phases]() {
+		return phases.time("SQL admin check", [this]() { return admin_check_setup_status(); });
+	});
+
+	bool schema_valid = false;
+	{
+		pqxx::connection setup_conn{ _connection_string };
+		schema_valid = phases.time("SQL schema validation", [&]() { return validate_subreddit_schema(setup_conn, _target_subreddit); });
+		if(schema_valid) {
+			phases.time("SQL migrations", [&]() { run_schema_migrations(setup_conn); });
+		}
+	}
+
+	if(!setup_status.get()) {
 		spdlog::critical("Database is not Setup");
 		return;
 	}
-	
-	conn = new pqxx::connection{ _connection_string };
-
-	if(!validate_subreddit_schema(_target_subreddit)) {
+	if(!schema_valid) {
 		spdlog::critical("Invalid Schema Setup for Subreddit! Restore");
 		return;
 	}
 
-	conn_mtx.lock();
-	pqxx::nontransaction txn{*conn};
-	txn.exec0(fmt::format("SET search_path TO {};", _target_subreddit));
-	conn_mtx.unlock();
-
-	prepared_statements = {
-		{ Prepareds::GET_TOTAL_PINNED,				{ "Get_Total_Pinned",		  "SELECT COUNT(*) AS all_total, sum(case when status = 1 then 1 else 0 end) AS all_pinned FROM comments;" } },
-		{ Prepareds::GET_DEV_RATIO,					{ "Get_Dev_Ratio",			  "SELECT COUNT(*) AS all_total, \
-																						(SELECT COUNT(*) FROM comments WHERE status = 1) AS all_pinned, \
-																						(SELECT COUNT(*) FROM comments WHERE LOWER(dev_username) = LOWER($1)) AS dev_total, \
-																						(SELECT COUNT(*) FROM comments WHERE LOWER(dev_username) = LOWER($1) AND status = 1) AS dev_pinned \
-																					FROM comments;" } },
-		{ Prepareds::INSERT_THREAD,			    	{ "Insert_Thread",            "INSERT INTO threads(Thread_ID, Sticky_ID) VALUES($1, $2);" } },
-		{ Prepareds::DELETE_THREAD,					{ "Delete_Thread",            "DELETE FROM threads WHERE Thread_ID = $1;" } },
-		{ Prepareds::GET_THREAD_ID,					{ "Get_Thread_ID",            "SELECT Thread_ID FROM comments WHERE Comment_ID = $1 LIMIT 1;" } },
-
-		{ Prepareds::INSERT_COMMENT,				{ "Insert_Comment",	          "INSERT INTO comments \
-																				   (Comment_ID, Thread_ID, Dev_Username, Status, Supervisor_Username, Supervisor_ID, Post_Epoch, Comment_Text) \
-																				   VALUES ($1, $2, $3, $4, $5, $6, $7, $8);" } },
-		{ Prepareds::UPDATE_COMMENT,				{ "Update_Comment",			  "UPDATE comments SET Comment_Text = $1, Post_Epoch = $2 WHERE Comment_ID = $3 AND Post_Epoch < $2;" } },
-		{ Prepareds::CHANGE_COMMENT_STATUS,			{ "Change_Comment_Status",	  "UPDATE comments SET Timestamp = CURRENT_TIMESTAMP, Status = $1, Supervisor_Username = $2, Supervisor_ID = $3 \
-																				   WHERE Comment_ID = $4 RETURNING Thread_ID;" } },
-		{ Prepareds::GET_COMMENT_STATUS,			{ "Get_Comment_Status",		  "SELECT status FROM comments WHERE comment_id = $1;" } },
-		{ Prepareds::DELETE_COMMENT, 				{ "Delete_Comment",			  "DELETE FROM comments WHERE Comment_ID = $1;" } },
-
-		{ Prepareds::INSERT_CONTEXT, 				{ "Insert_Context",			  "INSERT INTO contexts(Context_ID, Thread_ID, Owner_Comment_ID, Status, Comment_Text) VALUES ($1, $2, $3, $4, $5);" } },
-		{ Prepareds::GET_CONTEXT, 					{ "Get_Context",			  "SELECT Comment_Text FROM contexts WHERE Owner_Comment_ID = $1 AND Status = true LIMIT 1;" } },
-		{ Prepareds::GET_CONTEXTS_BY_THREAD, 		{ "Get_Context_By_Thread",	  "SELECT Owner_Comment_ID, Comment_Text FROM contexts WHERE thread_id = $1 AND Status = true;" } },
-
-		{ Prepareds::ENQUEUE_UPDATE,				{ "Enqueue_Update",			  "INSERT INTO update_queue (Thread_ID) VALUES ($1) ON CONFLICT DO NOTHING;" } },
-		{ Prepareds::DEQUEUE_UPDATE,				{ "Dequeue_Update",			  "DELETE FROM update_queue WHERE Thread_ID = $1;" } },
-		{ Prepareds::UPDATE_QUEUE_SIZE,         	{ "Update_Queue_Size",		  "SELECT FROM update_queue WHERE Thread_ID = $1;" } },
-		{ Prepareds::GET_UPDATE_QUEUE,          	{ "Get_Update_Queue",		  "SELECT Thread_ID FROM update_queue;" } },
-
-		{ Prepareds::UPSERT_DEV,                	{ "Upsert_Dev",				  "INSERT INTO devs(Dev_Username, Expertise, Status, Supervisor_Username, Supervisor_ID, \
-																				   Last_Modifier_Username, Last_Modifier_ID) \
-																				   VALUES ($1, $2, $3, $4, $5, $4, $5) \
-																				   ON CONFLICT (Dev_Username) DO UPDATE \
-																				   SET Status = $3::SMALLINT, Last_Modifier_Username = $4, Last_Modifier_ID = $5, Last_Modified = CURRENT_TIMESTAMP;" } },
-		{ Prepareds::UPDATE_DEV_STATUS,         	{ "Update_Dev_Status",		  "UPDATE devs SET Status = $1, Last_Modifier_Username = $2, Last_Modifier_ID = $3, Last_Modified = CURRENT_TIMESTAMP \
-																		 		   WHERE Dev_Username = $4;" } },
-		{ Prepareds::UPDATE_DEV_EXPERTISE,      	{ "Update_Dev_Expertise",	  "UPDATE devs SET Expertise = $1, Last_Modifier_Username = $2, Last_Modifier_ID = $3, Last_Modified = CURRENT_TIMESTAMP \
-																				   WHERE Dev_Username = $4;" } },
-		{ Prepareds::DELETE_DEV_EXPERTISE,			{ "Delete_Dev_Expertise",	  "UPDATE devs SET Expertise = '', Last_Modifier_Username = $1, Last_Modifier_ID = $2, Last_Modified = CURRENT_TIMESTAMP \
-																				   WHERE Dev_Username = $3;" } },
-		
-		{ Prepareds::INSERT_DEVEDIT_SESSION,    	{ "Insert_DevEdit_Session",	  "INSERT INTO devedit_sessions(dev_username, managing_msg, msg_channel) \
-																				   VALUES($1, $2, $3);" } },
-		{ Prepareds::DELETE_DEVEDIT_SESSION,    	{ "Delete_DevEdit_Session",	  "DELETE FROM devedit_sessions WHERE dev_username = $1;" } },
-
-		{ Prepareds::GET_STICKY_ID,                 { "Get_Sticky_ID",			  "SELECT Sticky_ID FROM threads WHERE Thread_ID = $1 LIMIT 1;" } },
-
-		{ Prepareds::CHECK_COMMENT_EXIST,           { "Check_Comment_Exist",	  "SELECT EXISTS(SELECT 1 FROM comments WHERE comment_id = $1);" } },
-		{ Prepareds::GET_OTHER_COMMENTS,            { "Get_Other_Comments",		  "SELECT Comment_ID, Thread_ID, Dev_Username, Post_Epoch, Comment_Text FROM comments WHERE Thread_ID = $1 AND Status = 1 \
-																				   ORDER BY Post_Epoch DESC;" } },
-		
-		{ Prepareds::GET_THREAD_IDS_BY_DATE,        { "Thread_IDs_By_Date",       "SELECT Thread_ID FROM threads WHERE Timestamp > CURRENT_DATE - $1::SMALLINT ORDER BY Timestamp DESC LIMIT 100;" } },
-		{ Prepareds::GET_COMMENT_IDS_BY_DATE,       { "Comments_By_Date",	      "SELECT Comment_ID FROM comments WHERE Timestamp > CURRENT_DATE - $1::SMALLINT \
-																				   AND Status = 1 ORDER BY Post_Epoch DESC LIMIT 1000;" } },
-		{ Prepareds::GET_COMMENT_IDS_BY_THREAD,     { "Comments_By_Thread",	      "SELECT Comment_ID FROM comments WHERE Thread_ID = $1 AND Status = 1 ORDER BY Post_Epoch DESC;" } },
-		{ Prepareds::COMMENT_EPOCH_PAIRS_BY_DATE,   { "Comment_Epochs_By_Date",	  "SELECT Comment_ID, Post_Epoch FROM comments WHERE Timestamp > CURRENT_DATE - $1::SMALLINT AND Status = 1 \
-																				   ORDER BY Post_Epoch DESC LIMIT 1000;" } },
-		{ Prepareds::COMMENT_EPOCH_PAIRS_BY_THREAD, { "Comment_Epochs_By_Thread", "SELECT Comment_ID, Post_Epoch FROM comments WHERE thread_id = $1 AND STATUS = 1 ORDER BY Post_Epoch DESC;" } },
-	};
-
-	conn_mtx.lock();
-	for(const auto& itr : prepared_statements) {
-		const Prep_Stm& current_stm = itr.second;
-		conn->prepare(current_stm.name, current_stm.statement);
-	}
-	conn_mtx.unlock();
+	//Every pooled connection (including reconnects) gets the schema path & the full set of prepared statements
+	phases.time("SQL pool & statement preparation", [&]() {
+		_pool = std::make_unique<Connection_Pool>(_connection_string, pool_size, [this](pqxx::connection& conn) {
+			{
+				pqxx::nontransaction txn{conn};
+				txn.exec0(fmt::format("SET search_path TO {};", _target_subreddit));
+			}
+			for(const auto& statement : Statement_Registry::table) {
+				conn.prepare(statement.name, statement.sql);
+			}
+		});
+	});
+
+	phases.time("SQL plan check", [this]() { verify_query_plans(); });
 }
 
 pqxx::result sql_handler::admin_query(const std::string& query_string) {
@@ -107,16 +357,9 @@ pqxx::result sql_handler::admin_query(const std::string& query_string) {
 
 	return pqxx::result{ admin_txn.exec(query_string) };
 }
-bool sql_handler::admin_existence_query(const std::string& query_string) {
-	pqxx::result r{ admin_query(query_string) };
-
-	return r[0][0].as<bool>();
-}
-bool sql_handler::validate_subreddit_schema(const std::string& subreddit) {
-	conn_mtx.lock();
-	pqxx::work txn{*conn};
+bool sql_handler::validate_subreddit_schema(pqxx::connection& conn, const std::string& subreddit) {
+	pqxx::work txn{conn};
 	pqxx::result r{ txn.exec(fmt::format("SELECT EXISTS(SELECT 1 FROM pg_namespace WHERE LOWER(nspname) = LOWER('{}'));", subreddit)) };
-	conn_mtx.unlock();
 
 	const bool exists = r[0][0].as<bool>();
 
@@ -126,272 +369,429 @@ bool sql_handler::validate_subreddit_schema(const std::string& subreddit) {
 	return exists;
 }
 
+void sql_handler::run_schema_migrations(pqxx::connection& conn) {
+	{
+		pqxx::work txn{conn};
+		txn.exec0(fmt::format("CREATE TABLE IF NOT EXISTS {}.schema_migrations ( \
+			Version INTEGER PRIMARY KEY, \
+			Description TEXT NOT NULL, \
+			Applied_At TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP \
+		);", _target_subreddit));
+		txn.commit();
+	}
+
+	for(const Schema_Migration& migration : schema_migrations()) {
+		pqxx::work txn{conn};
+
+		//Serialises bots starting against the same schema; released with the transaction
+		txn.exec1(fmt::format("SELECT pg_advisory_xact_lock(hashtext('{}.schema_migrations'));", _target_subreddit));
+
+		const bool applied = txn.exec1(fmt::format("SELECT EXISTS(SELECT 1 FROM {}.schema_migrations WHERE Version = {});", 
+			_target_subreddit, migration.version))[0].as<bool>();
+		if(applied) {
+			continue;
+		}
+
+		spdlog::info("SQL: Applying schema migration {} - {}", migration.version, migration.description);
+		for(const auto& statement : migration.statements) {
+			txn.exec0(fmt::format(statement, _target_subreddit));
+		}
+		txn.exec0(fmt::format("INSERT INTO {}.schema_migrations (Version, Description) VALUES ({}, {});", 
+			_target_subreddit, migration.version, txn.quote(migration.description)));
+
+		txn.commit();
+	}
+}
+void sql_handler::verify_query_plans() {
+	struct Plan_Check {
+		Prepareds statement;
+		std::string args;
+		//Table whose size decides whether the planner's choice means anything
+		std::string table;
+		//The plan must use one of these; empty for lookups on the base schema's own keys, which only have to avoid a Seq Scan
+		std::vector<std::string> indexes;
+	};
+	//Hot statements with representative arguments
+	const std::vector<Plan_Check> hot_queries = {
+		{ Prepareds::CHECK_COMMENT_EXIST, "''", "comments", {} },
+		{ Prepareds::GET_OTHER_COMMENTS, "''", "comments", { "comments_thread_approved_idx" } },
+		{ Prepareds::GET_THREAD_SNAPSHOT, "''", "comments", { "comments_thread_approved_idx" } },
+		{ Prepareds::GET_CONTEXT, "''", "contexts", { "contexts_owner_active_idx" } },
+		{ Prepareds::GET_CONTEXTS_BY_THREAD, "''", "contexts", { "contexts_thread_active_idx" } },
+		{ Prepareds::GET_COMMENT_IDS_BY_THREAD, "''", "comments", { "comments_thread_approved_idx" } },
+		{ Prepareds::COMMENT_EPOCH_PAIRS_BY_THREAD, "''", "comments", { "comments_thread_approved_idx" } },
+		{ Prepareds::THREAD_ID_PAGE_BY_DATE, "7, 'infinity', '', 100", "threads", { "threads_timestamp_keyset_idx" } },
+		{ Prepareds::COMMENT_EPOCH_PAGE_BY_DATE, "7, 9223372036854775807, '', 100", "comments", { "comments_approved_keyset_idx", "comments_approved_timestamp_idx" } },
+		{ Prepareds::GET_ARCHIVED_THREAD_ID, "''", "comments_archive", {} }
+	};
+
+	Connection_Pool::Lease conn = _pool->acquire();
+	pqxx::work txn{*conn};
+
+	//A sequential scan is the right plan for a small table, so only tables past the threshold are held to their index -
+	//the planner runs with its normal settings, so what is checked is what production will run
+	std::unordered_map<std::string, double> table_rows;
+	for(const auto& row : txn.exec("SELECT c.relname, c.reltuples FROM pg_catalog.pg_class AS c \
+		JOIN pg_catalog.pg_namespace AS n ON n.oid = c.relnamespace WHERE n.nspname = current_schema() AND c.relkind = 'r';")) {
+		table_rows.emplace(row[0].as<std::string>(), row[1].as<double>());
+	}
+
+	std::string failures;
+	for(const auto& check : hot_queries) {
+		const std::string name = Statement_Registry::get(check.statement).name;
+		const auto rows = table_rows.find(check.table);
+		if(rows == table_rows.end() || rows->second < plan_check_min_rows) {
+			spdlog::debug("SQL: Skipping the plan check of {} - {} is below {} rows", name, check.table, plan_check_min_rows);
+			continue;
+		}
+
+		const pqxx::result plan{ txn.exec(fmt::format("EXPLAIN EXECUTE {}({});", txn.quote_name(name), check.args)) };
+		std::string plan_text;
+		for(const auto& row : plan) {
+			plan_text += row[0].as<std::string>() + "\n";
+		}
+
+		//The name has to end the token, so comments never matches comments_archive
+		auto plan_mentions = [&plan_text](const std::string& prefix, const std::string& identifier) {
+			const std::string needle = prefix + identifier;
+			for(std::size_t pos = plan_text.find(needle); pos != std::string::npos; pos = plan_text.find(needle, pos + 1)) {
+				const char next = plan_text[pos + needle.size()];
+				if(next == ' ' || next == '\n') {
+					return true;
+				}
+			}
+			return false;
+		};
+		//"Index [Only] Scan using <index>" or "Bitmap Index Scan on <index>"
+		const bool uses_index = check.indexes.empty()
+			? !plan_mentions("Seq Scan on ", check.table)
+			: std::any_of(check.indexes.begin(), check.indexes.end(), [&](const std::string& index) {
+				return plan_mentions("using ", index) || plan_mentions("Index Scan on ", index);
+			});
+		if(!uses_index) {
+			spdlog::critical("SQL: {} doesn't use its index on {}:\n{}", name, check.table, plan_text);
+			failures += failures.empty() ? name : ", " + name;
+		}
+	}
+	txn.abort();
+
+	if(!failures.empty()) {
+		throw std::runtime_error("SQL: Hot queries without a usable index - " + failures);
+	}
+}
+
 bool sql_handler::admin_check_setup_status() {
-	conn_mtx.lock();
-	bool user_exists = admin_existence_query(fmt::format("SELECT EXISTS(SELECT 1 FROM pg_catalog.pg_roles WHERE rolname = '{}');", "rf_bot"));
-	bool db_exists = admin_existence_query("SELECT EXISTS(SELECT 1 FROM pg_database where datname = 'rf_data');");
-	conn_mtx.unlock();
+	//Both checks share one admin connection & round trip
+	pqxx::result r{ admin_query(fmt::format("SELECT EXISTS(SELECT 1 FROM pg_catalog.pg_roles WHERE rolname = '{}'), \
+		EXISTS(SELECT 1 FROM pg_database where datname = 'rf_data');", "rf_bot")) };
+
+	const bool user_exists = r[0][0].as<bool>();
+	const bool db_exists = r[0][1].as<bool>();
 
 	return user_exists && db_exists;
 }
 
+void sql_handler::set_dev_stats_listener(Dev_Id_Resolver resolve, Dev_Stats_Listener listener) {
+	_dev_id_resolver = std::move(resolve);
+	_dev_stats_listener = std::move(listener);
+}
+void sql_handler::notify_dev_stats(const std::string& dev, int total_delta, int pinned_delta) {
+	if(!_dev_stats_listener || (total_delta == 0 && pinned_delta == 0)) {
+		return;
+	}
+	const Username_Interner::Id id = _dev_id_resolver(dev);
+	if(id == Username_Interner::invalid_id) {
+		return;
+	}
+	if(transaction_depth > 0) {
+		uncommitted_dev_stats.push_back({ id, total_delta, pinned_delta });
+		return;
+	}
+
+	_dev_stats_listener(id, total_delta, pinned_delta);
+}
+
 std::unordered_map<std::string, Target> sql_handler::get_dev_map() {
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
 	pqxx::result devs{ txn.exec("SELECT Dev_Username, Expertise, Status FROM devs;") };
 	pqxx::result edit_sessions{ txn.exec("SELECT Dev_Username, Managing_Msg, Msg_Channel FROM devedit_sessions;") };
-	pqxx::result ratio{ txn.exec("SELECT dev_username, COUNT(*) AS total, sum(case when status = 1 then 1 else 0 end) AS pinnedcount \
-								  FROM comments GROUP BY dev_username;")};
+	pqxx::result ratio{ txn.exec("SELECT Dev_Key, Total, Pinned FROM dev_stats WHERE Dev_Key <> '';") };
 
-	conn_mtx.unlock();
-
-	std::unordered_map<std::string, Target> res;
-	res.reserve(devs.size());
+	//Filled in place here, then handed out read-only
+	std::unordered_map<std::string, std::shared_ptr<Target::Data>> dev_data;
+	dev_data.reserve(devs.size());
+	std::unordered_map<std::string, std::shared_ptr<Target::Stats>> dev_counts;
+	dev_counts.reserve(devs.size());
 
 	for(const auto& row : devs) {
-		Target current_dev;
-		current_dev.data = std::make_shared<Target::Data>();
-		current_dev.data->username = row[0].as<std::string>();
-		current_dev.data->expertise = row[1].as<std::string>();
-		current_dev.data->status = static_cast<Target::Status>(row[2].as<int>());
+		auto current_dev = std::make_shared<Target::Data>();
+		current_dev->username = row[0].as<std::string>();
+		current_dev->expertise = row[1].as<std::string>();
+		current_dev->status = static_cast<Target::Status>(row[2].as<int>());
 
-		res.emplace(current_dev.data->username, current_dev);
+		dev_data.emplace(current_dev->username, current_dev);
+		dev_counts.emplace(current_dev->username, std::make_shared<Target::Stats>());
 	}
 	for(const auto& row : edit_sessions) {
-		std::unordered_map<std::string, Target>::iterator itr = res.find(row[0].as<std::string>());
-		if(itr == res.end()) {
+		const auto itr = dev_data.find(row[0].as<std::string>());
+		if(itr == dev_data.end()) {
 			continue;
 		}
-		itr->second.data->managing_msg_id = row[1].as<int64_t>();
-		itr->second.data->msg_channel = row[2].as<int64_t>();
+		itr->second->managing_msg_id = row[1].as<int64_t>();
+		itr->second->msg_channel = row[2].as<int64_t>();
+	}
+
+	//dev_stats keys are lowercase - matched case-insensitively in place rather than lowercasing every name
+	std::unordered_map<std::string_view, Target::Stats*, Case_Insensitive_Hash, Case_Insensitive_Equal> devs_by_key;
+	devs_by_key.reserve(dev_counts.size());
+	for(const auto& itr : dev_counts) {
+		devs_by_key.emplace(itr.first, itr.second.get());
 	}
 	for(const auto& row : ratio) {
-		std::unordered_map<std::string, Target>::iterator itr = res.find(row[0].as<std::string>());
-		if(itr == res.end()) {
+		const auto itr = devs_by_key.find(row[0].view());
+		if(itr == devs_by_key.end()) {
 			continue;
 		}
-		itr->second.data->dev_total = row[1].as<int>();
-		itr->second.data->dev_pinned = row[2].as<int>();
+		itr->second->dev_total = row[1].as<int>();
+		itr->second->dev_pinned = row[2].as<int>();
+	}
+
+	std::unordered_map<std::string, Target> res;
+	res.reserve(dev_data.size());
+	for(auto& itr : dev_data) {
+		res.emplace(itr.first, Target{ std::move(itr.second), std::move(dev_counts[itr.first]) });
 	}
 	
 	return res;
 }
 std::pair<int, int> sql_handler::get_total_pinned() {
-	const std::string& stm = prepared_statements[Prepareds::GET_TOTAL_PINNED].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	/*SELECT COUNT(*) AS all_total,
-		sum(case when status = 1 then 1 else 0 end) AS all_pinned
-	FROM comments;*/
-	pqxx::result r{ txn.exec_prepared(stm) };
-	conn_mtx.unlock();	
+	//"SELECT COALESCE(SUM(Total), 0), COALESCE(SUM(Pinned), 0) FROM dev_stats WHERE Dev_Key = '';"
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_TOTAL_PINNED>(txn) };
+
+	const auto [total, pinned] = Statement_Registry::read<Prepareds::GET_TOTAL_PINNED>(r[0]);
 
-	return std::pair<int, int>{ r[0][0].as<int>(), r[0][1].as<int>() };;
+	return std::pair<int, int>{ total, pinned };
 }
 sql_handler::Dev_Ratio sql_handler::get_dev_ratio(const std::string& dev) {
-	const std::string& stm = prepared_statements[Prepareds::GET_DEV_RATIO].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	/*SELECT COUNT(*) AS all_total,
-		(SELECT COUNT(*) FROM comments WHERE status = 1) AS all_pinned,
-		(SELECT COUNT(*) FROM comments WHERE dev_username = $1) AS dev_total,
-		(SELECT COUNT(*) FROM comments WHERE dev_username = $1 AND status = 1) AS dev_pinned
-	FROM comments;*/
-	pqxx::result r{ txn.exec_prepared(stm, dev) };
-	conn_mtx.unlock();
+	/*SELECT COALESCE(SUM(Total) FILTER (WHERE Dev_Key = ''), 0) AS all_total,
+		COALESCE(SUM(Pinned) FILTER (WHERE Dev_Key = ''), 0) AS all_pinned,
+		COALESCE(SUM(Total) FILTER (WHERE Dev_Key = LOWER($1)), 0) AS dev_total,
+		COALESCE(SUM(Pinned) FILTER (WHERE Dev_Key = LOWER($1)), 0) AS dev_pinned
+	FROM dev_stats WHERE Dev_Key IN ('', LOWER($1));*/
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_DEV_RATIO>(txn, dev) };
 
-	Dev_Ratio res;
-	res.all_total = r[0][0].as<int>();
-	res.all_pinned = r[0][1].as<int>();
-	res.dev_total = r[0][2].as<int>();
-	res.dev_pinned = r[0][3].as<int>();
-
-	return res;
+	return Statement_Registry::decode<Dev_Ratio, Prepareds::GET_DEV_RATIO>(r[0]);
 }
 
-void sql_handler::insert_thread(const std::string& thread_id, const std::string& sticky_id) {
-	const std::string& stm = prepared_statements[Prepareds::INSERT_THREAD].name;
+void sql_handler::insert_thread(const std::string& thread_id, const std::string& sticky_id, int64_t body_digest) {
+	Connection_Pool::Lease conn = _pool->acquire();
+	pqxx::nontransaction txn{*conn};
+
+	//"INSERT INTO threads(Thread_ID, Sticky_ID, Body_Digest) VALUES($1, $2, $3::BIGINT);"
+	Statement_Registry::exec<Prepareds::INSERT_THREAD>(txn, thread_id, sticky_id, body_digest);
 
-	conn_mtx.lock();
+	patch_thread(thread_id, [&sticky_id, body_digest](Thread_Snapshot& snapshot) {
+		snapshot.sticky_id = sticky_id;
+		snapshot.body_digest = body_digest;
+	});
+}
+void sql_handler::set_thread_digest(const std::string& thread_id, int64_t body_digest) {
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	//"INSERT INTO threads(Thread_ID, Sticky_ID) VALUES($1, $2);"
-	txn.exec_prepared(stm, thread_id, sticky_id);
-	conn_mtx.unlock();
+	//"UPDATE threads SET Body_Digest = $2::BIGINT WHERE Thread_ID = $1;"
+	Statement_Registry::exec<Prepareds::SET_THREAD_DIGEST>(txn, thread_id, body_digest);
+
+	patch_thread(thread_id, [body_digest](Thread_Snapshot& snapshot) {
+		snapshot.body_digest = body_digest;
+	});
 }
 void sql_handler::delete_thread(const std::string& thread_id) {
-	const std::string& stm = prepared_statements[Prepareds::DELETE_THREAD].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
 	//"DELETE FROM threads WHERE Thread_ID = $1;"
-	txn.exec_prepared(stm, thread_id);
-	conn_mtx.unlock();
+	Statement_Registry::exec<Prepareds::DELETE_THREAD>(txn, thread_id);
+
+	patch_thread(thread_id, [](Thread_Snapshot& snapshot) {
+		snapshot.sticky_id.clear();
+		snapshot.body_digest.reset();
+	});
 }
 std::string sql_handler::get_thread_id(const std::string& comment_id) {
-	const std::string& stm = prepared_statements[Prepareds::GET_THREAD_ID].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
 	//"SELECT Thread_ID FROM comments WHERE Comment_ID = $1 LIMIT 1;"
-	pqxx::result r{ txn.exec_prepared(stm, comment_id) };
-	conn_mtx.unlock();
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_THREAD_ID>(txn, comment_id) };
 
 	return r[0][0].as<std::string>();
 }
 
 void sql_handler::insert_comment(const std::string& comment_id, const std::string& thread_id, 
-	const std::string& dev, int status, const std::string& supervisor, int64_t supervisor_id, int64_t epoch_time, const std::string& comment_text) 
+	const std::string& dev, int status, const std::string& supervisor, int64_t supervisor_id, int64_t epoch_time, int64_t created_epoch, const std::string& comment_text) 
 {
-	const std::string& stm = prepared_statements[Prepareds::INSERT_COMMENT].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	//"INSERT INTO comments \
-	   (Comment_ID, Thread_ID, Dev_Username, Status, Supervisor_Username, Supervisor_ID, Post_Epoch, Comment_Text) \
-	   VALUES ($1, $2, $3, $4, $5, $6, $7, $8);"
-	txn.exec_prepared0(stm, comment_id, thread_id, dev, status, supervisor, supervisor_id, epoch_time, comment_text);
-	conn_mtx.unlock();
+	//"WITH restored_contexts AS (DELETE FROM contexts_archive WHERE Thread_ID = $2 RETURNING *), \
+	   back_contexts AS (INSERT INTO contexts SELECT * FROM restored_contexts), \
+	   restored AS (DELETE FROM comments_archive WHERE Thread_ID = $2 RETURNING *), \
+	   back AS (INSERT INTO comments SELECT * FROM restored) \
+	   INSERT INTO comments \
+	   (Comment_ID, Thread_ID, Dev_Username, Status, Supervisor_Username, Supervisor_ID, Post_Epoch, Created_Epoch, Comment_Text) \
+	   VALUES ($1, $2, $3, $4::SMALLINT, $5, $6::BIGINT, $7::BIGINT, $8::BIGINT, $9);"
+	Statement_Registry::exec<Prepareds::INSERT_COMMENT>(txn, comment_id, thread_id, dev, status, supervisor, supervisor_id, epoch_time, created_epoch, comment_text);
+
+	if(status == 1) {
+		invalidate_thread(thread_id);
+	}
+	if(transaction_depth > 0) {
+		uncommitted_comment_ids.emplace_back(comment_id);
+	}
+	else {
+		_comment_index.insert(comment_id);
+	}
+	notify_dev_stats(dev, 1, status == 1 ? 1 : 0);
 }
 void sql_handler::update_comment(const std::string& comment_id, const std::string& text, int64_t modified_epoch) {
-	const std::string& stm = prepared_statements[Prepareds::UPDATE_COMMENT].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	//"UPDATE comments SET Comment_Text = $1, Post_Epoch = $2 WHERE Comment_ID = $3 AND Post_Epoch < $2;"
-	txn.exec_prepared0(stm, text, modified_epoch, comment_id);
-	conn_mtx.unlock();
-}
-std::string sql_handler::change_comment_status(const std::string& comment_id, int status, const std::string& supervisor, int64_t supervisor_id) {
-	const std::string& stm = prepared_statements[Prepareds::CHANGE_COMMENT_STATUS].name;
+	//"UPDATE comments SET Comment_Text = $1, Post_Epoch = $2::BIGINT WHERE Comment_ID = $3 AND Post_Epoch < $2::BIGINT RETURNING Thread_ID;"
+	pqxx::result r{ Statement_Registry::exec<Prepareds::UPDATE_COMMENT>(txn, text, modified_epoch, comment_id) };
 
-	conn_mtx.lock();
+	for(const auto& row : r) {
+		invalidate_thread(std::get<0>(Statement_Registry::read<Prepareds::UPDATE_COMMENT>(row)));
+	}
+}
+sql_handler::Status_Change sql_handler::change_comment_status(const std::string& comment_id, int status, const std::string& supervisor, int64_t supervisor_id) {
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	//"UPDATE comments SET Timestamp = CURRENT_TIMESTAMP, Status = $1, Supervisor_Username = $2, Supervisor_ID = $3 WHERE Comment_ID = $4 RETURNING Thread_ID;"
-	pqxx::result r{ txn.exec_prepared(stm, status, supervisor, supervisor_id, comment_id) };
-	conn_mtx.unlock();
+	//"UPDATE comments AS c SET Timestamp = CURRENT_TIMESTAMP, Status = $1::SMALLINT, Supervisor_Username = $2, Supervisor_ID = $3::BIGINT \
+	   FROM (SELECT Comment_ID, Status FROM comments WHERE Comment_ID = $4 FOR UPDATE) AS o \
+	   WHERE c.Comment_ID = o.Comment_ID RETURNING c.Thread_ID, c.Dev_Username, o.Status, COALESCE(c.Created_Epoch, c.Post_Epoch), c.Comment_Text;"
+	pqxx::result r{ Statement_Registry::exec<Prepareds::CHANGE_COMMENT_STATUS>(txn, status, supervisor, supervisor_id, comment_id) };
+	if(r.empty() && restore_archived_comment(txn, comment_id)) {
+		r = Statement_Registry::exec<Prepareds::CHANGE_COMMENT_STATUS>(txn, status, supervisor, supervisor_id, comment_id);
+	}
+	if(r.empty()) {
+		throw std::runtime_error("SQL: Comment " + comment_id + " does not exist.");
+	}
 
-	return r[0][0].as<std::string>();
+	const Status_Change res = Statement_Registry::decode<Status_Change, Prepareds::CHANGE_COMMENT_STATUS>(r[0]);
+
+	invalidate_thread(res.thread_id);
+
+	notify_dev_stats(res.dev, 0, (status == 1 ? 1 : 0) - (res.old_status == 1 ? 1 : 0));
+
+	return res;
 }
 bool sql_handler::get_comment_status(const std::string& comment_id) {
-	const std::string& stm = prepared_statements[Prepareds::GET_COMMENT_STATUS].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 	
 	//"SELECT status FROM comments WHERE comment_id = $1;"
-	pqxx::result r{ txn.exec_prepared(stm, comment_id) };
-	conn_mtx.unlock();
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_COMMENT_STATUS>(txn, comment_id) };
+	if(r.empty() && restore_archived_comment(txn, comment_id)) {
+		r = Statement_Registry::exec<Prepareds::GET_COMMENT_STATUS>(txn, comment_id);
+	}
+	if(r.empty()) {
+		throw std::runtime_error("SQL: Comment " + comment_id + " does not exist.");
+	}
 
 	return r[0][0].as<bool>();
 }
 void sql_handler::delete_comment(const std::string& comment_id) {
-	const std::string& stm = prepared_statements[Prepareds::DELETE_COMMENT].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	//"DELETE FROM comments WHERE Comment_ID = $1;"
-	txn.exec_prepared0(stm, comment_id);
-	conn_mtx.unlock();
+	//"DELETE FROM comments WHERE Comment_ID = $1 RETURNING Dev_Username, Status, Thread_ID;"
+	pqxx::result r{ Statement_Registry::exec<Prepareds::DELETE_COMMENT>(txn, comment_id) };
+
+	_comment_index.erase(comment_id);
+	for(const auto& row : r) {
+		const auto [dev, status, thread_id] = Statement_Registry::read<Prepareds::DELETE_COMMENT>(row);
+		notify_dev_stats(dev, -1, status == 1 ? -1 : 0);
+		remove_from_thread(thread_id, comment_id);
+	}
 }
 
 void sql_handler::insert_context(const std::string& context_id, const std::string& thread_id, const std::string& owner_id, bool status, const std::string& text) {
-	const std::string& stm = prepared_statements[Prepareds::INSERT_CONTEXT].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
 	//"INSERT INTO contexts(Context_ID, Thread_ID, Owner_Comment_ID, Status, Comment_Text) VALUES ($1, $2, $3, $4, $5);"
-	txn.exec_prepared0(stm, context_id, thread_id, owner_id, status, text);
-	conn_mtx.unlock();
+	Statement_Registry::exec<Prepareds::INSERT_CONTEXT>(txn, context_id, thread_id, owner_id, status, text);
+
+	invalidate_thread(thread_id);
 }
 std::string sql_handler::get_context(const std::string& comment_id) {
-	const std::string& stm = prepared_statements[Prepareds::GET_CONTEXT].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
 	//"SELECT Comment_Text FROM contexts WHERE Owner_Comment_ID = $1 AND Status = true LIMIT 1;"
-	pqxx::result r{ txn.exec_prepared(stm, comment_id) };
-	conn_mtx.unlock();
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_CONTEXT>(txn, comment_id) };
 
 	return r.empty() ? "" : r[0][0].as<std::string>();
 }
 std::unordered_map<std::string, std::string> sql_handler::get_contexts_for_thread(const std::string& thread_id) {
-	const std::string& stm = prepared_statements[Prepareds::GET_CONTEXTS_BY_THREAD].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
 	//"SELECT Owner_Comment_ID, Comment_Text FROM contexts WHERE thread_id = $1 AND status = true;"
-	pqxx::result r{ txn.exec_prepared(stm, thread_id) };
-	conn_mtx.unlock();
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_CONTEXTS_BY_THREAD>(txn, thread_id) };
 
 	std::unordered_map<std::string, std::string> res;
 	res.reserve(r.size());
 
     for(const auto& row : r) {
-		std::string owner_comment_id = row[0].as<std::string>();
-		std::string comment_text = row[1].as<std::string>();
-
-		res.emplace(owner_comment_id, comment_text);
+		auto [owner_comment_id, comment_text] = Statement_Registry::read<Prepareds::GET_CONTEXTS_BY_THREAD>(row);
+		res.emplace(std::move(owner_comment_id), std::move(comment_text));
     }   
 	
 	return res;
 }
 
 void sql_handler::enqueue_update(const std::string& thread_id) {
-	const std::string& stm = prepared_statements[Prepareds::ENQUEUE_UPDATE].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	//"INSERT INTO update_queue (Thread_ID) VALUES ($1) ON CONFLICT DO NOTHING;"
-	txn.exec_prepared0(stm, thread_id);
-	conn_mtx.unlock();
+	//"WITH q AS (INSERT INTO update_queue (Thread_ID) VALUES ($1) ON CONFLICT DO NOTHING) \
+	   SELECT pg_notify(LOWER(current_schema()) || '_update_queue', $1);"
+	Statement_Registry::exec<Prepareds::ENQUEUE_UPDATE>(txn, thread_id);
 }
 void sql_handler::dequeue_update(const std::string& thread_id) {
-	const std::string& stm = prepared_statements[Prepareds::DEQUEUE_UPDATE].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
 	//DELETE FROM update_queue WHERE Thread_ID = $1;
-	txn.exec_prepared0(stm, thread_id);
-	conn_mtx.unlock();
+	Statement_Registry::exec<Prepareds::DEQUEUE_UPDATE>(txn, thread_id);
 }
 int sql_handler::update_queue_size(const std::string& thread_id) {
-	const std::string& stm = prepared_statements[Prepareds::UPDATE_QUEUE_SIZE].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
 	//"SELECT FROM update_queue WHERE thread_id = $1;"
-	pqxx::result r{ txn.exec_prepared(stm, thread_id) };
-	conn_mtx.unlock();
+	pqxx::result r{ Statement_Registry::exec<Prepareds::UPDATE_QUEUE_SIZE>(txn, thread_id) };
 
 	return r.size();
 }
 std::unordered_set<std::string> sql_handler::get_update_queue() {
-	const std::string& stm = prepared_statements[Prepareds::GET_UPDATE_QUEUE].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
 	//"SELECT Thread_ID FROM update_queue;"
-	pqxx::result r{ txn.exec_prepared(stm) };
-	conn_mtx.unlock();
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_UPDATE_QUEUE>(txn) };
 
 	std::unordered_set<std::string> res;
 	res.reserve(r.size());
@@ -403,174 +803,284 @@ std::unordered_set<std::string> sql_handler::get_update_queue() {
 	return res;
 }
 
-void sql_handler::upsert_dev(const std::string& dev, const std::string& expertise, Target::Status status, const std::string& supervisor, int64_t supervisor_id) {
-	const std::string& stm = prepared_statements[Prepareds::UPSERT_DEV].name;
+std::string sql_handler::get_tracker_state(const std::string& key) {
+	Connection_Pool::Lease conn = _pool->acquire();
+	pqxx::nontransaction txn{*conn};
+
+	//"SELECT State_Value FROM tracker_state WHERE State_Key = $1;"
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_TRACKER_STATE>(txn, key) };
+
+	return r.empty() ? std::string() : r[0][0].as<std::string>();
+}
+void sql_handler::set_tracker_state(const std::string& key, const std::string& value) {
+	Connection_Pool::Lease conn = _pool->acquire();
+	pqxx::nontransaction txn{*conn};
+
+	//"INSERT INTO tracker_state(State_Key, State_Value) VALUES($1, $2) \
+	   ON CONFLICT (State_Key) DO UPDATE SET State_Value = EXCLUDED.State_Value, Updated_At = CURRENT_TIMESTAMP;"
+	Statement_Registry::exec<Prepareds::SET_TRACKER_STATE>(txn, key, value);
+}
+void sql_handler::insert_pending_approval(const std::string& comment_id, int status) {
+	Connection_Pool::Lease conn = _pool->acquire();
+	pqxx::nontransaction txn{*conn};
+
+	//"INSERT INTO pending_approvals(Comment_ID, Status) VALUES($1, $2::SMALLINT) ON CONFLICT (Comment_ID) DO NOTHING;"
+	Statement_Registry::exec<Prepareds::INSERT_PENDING_APPROVAL>(txn, comment_id, status);
+}
+void sql_handler::delete_pending_approval(const std::string& comment_id) {
+	Connection_Pool::Lease conn = _pool->acquire();
+	pqxx::nontransaction txn{*conn};
 
-	conn_mtx.lock();
+	//"DELETE FROM pending_approvals WHERE Comment_ID = $1;"
+	Statement_Registry::exec<Prepareds::DELETE_PENDING_APPROVAL>(txn, comment_id);
+}
+std::vector<sql_handler::Pending_Approval> sql_handler::get_pending_approvals() {
+	Connection_Pool::Lease conn = _pool->acquire();
+	pqxx::nontransaction txn{*conn};
+
+	/*WITH orphaned AS (DELETE FROM pending_approvals AS p WHERE NOT EXISTS (SELECT 1 FROM comments AS c WHERE c.Comment_ID = p.Comment_ID))
+	SELECT p.Comment_ID, p.Status, c.Thread_ID, c.Dev_Username, COALESCE(c.Created_Epoch, c.Post_Epoch), c.Comment_Text
+	FROM pending_approvals AS p JOIN comments AS c ON c.Comment_ID = p.Comment_ID ORDER BY p.Queued_At, p.Comment_ID;*/
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_PENDING_APPROVALS>(txn) };
+
+	std::vector<Pending_Approval> res;
+	res.reserve(r.size());
+	for(const auto& row : r) {
+		res.push_back(Statement_Registry::decode<Pending_Approval, Prepareds::GET_PENDING_APPROVALS>(row));
+	}
+
+	return res;
+}
+
+void sql_handler::upsert_dev(const std::string& dev, const std::string& expertise, Target::Status status, const std::string& supervisor, int64_t supervisor_id) {
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
 	//"INSERT INTO devs (Dev_Username, Expertise, Status, Supervisor_Username, Supervisor_ID, Last_Modifier_Username, Last_Modifier_ID) \
-	   VALUES ($1, $2, $3, $4, $5, $4, $5) \
+	   VALUES ($1, $2, $3::SMALLINT, $4, $5::BIGINT, $4, $5::BIGINT) \
 	   ON CONFLICT (Dev_Username) DO UPDATE \
-	   SET Status = $3::SMALLINT, Last_Modifier_Username = $4, Last_Modifier_ID = $5, Last_Modified = CURRENT_TIMESTAMP;"
-	txn.exec_prepared0(stm, dev, expertise, static_cast<int>(status), supervisor, supervisor_id);
-	conn_mtx.unlock();
+	   SET Status = $3::SMALLINT, Last_Modifier_Username = $4, Last_Modifier_ID = $5::BIGINT, Last_Modified = CURRENT_TIMESTAMP;"
+	Statement_Registry::exec<Prepareds::UPSERT_DEV>(txn, dev, expertise, static_cast<int>(status), supervisor, supervisor_id);
 }
 void sql_handler::update_dev_status(const std::string& dev, Target::Status new_status, const std::string& supervisor, int64_t supervisor_id) {
-	const std::string& stm = prepared_statements[Prepareds::UPDATE_DEV_STATUS].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	//"UPDATE devs SET Status = $1, Last_Modifier_Username = $2, Last_Modifier_ID = $3, Last_Modified = CURRENT_TIMESTAMP \
+	//"UPDATE devs SET Status = $1::SMALLINT, Last_Modifier_Username = $2, Last_Modifier_ID = $3::BIGINT, Last_Modified = CURRENT_TIMESTAMP \
 	   WHERE Dev_Username = $4;"
-	txn.exec_prepared0(stm, static_cast<int>(new_status), supervisor, supervisor_id, dev);
-	conn_mtx.unlock();
+	Statement_Registry::exec<Prepareds::UPDATE_DEV_STATUS>(txn, static_cast<int>(new_status), supervisor, supervisor_id, dev);
 }
 void sql_handler::update_dev_expertise(const std::string& dev, const std::string& expertise, const std::string& supervisor, int64_t supervisor_id) {
-	const std::string& stm = prepared_statements[Prepareds::UPDATE_DEV_EXPERTISE].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	//"UPDATE devs SET Expertise = $1, Last_Modifier_Username = $2, Last_Modifier_ID = $3, Last_Modified = CURRENT_TIMESTAMP \
+	//"UPDATE devs SET Expertise = $1, Last_Modifier_Username = $2, Last_Modifier_ID = $3::BIGINT, Last_Modified = CURRENT_TIMESTAMP \
        WHERE Dev_Username = $4;"
-	txn.exec_prepared0(stm, expertise, supervisor, supervisor_id, dev);
-	conn_mtx.unlock();
+	Statement_Registry::exec<Prepareds::UPDATE_DEV_EXPERTISE>(txn, expertise, supervisor, supervisor_id, dev);
 }
 void sql_handler::delete_dev_expertise(const std::string& dev, const std::string& supervisor, int64_t supervisor_id) {
-	const std::string& stm = prepared_statements[Prepareds::DELETE_DEV_EXPERTISE].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	//"UPDATE devs SET Expertise = '', Last_Modifier_Username = $1, Last_Modifier_ID = $2, Last_Modified = CURRENT_TIMESTAMP \
+	//"UPDATE devs SET Expertise = '', Last_Modifier_Username = $1, Last_Modifier_ID = $2::BIGINT, Last_Modified = CURRENT_TIMESTAMP \
        WHERE Dev_Username = $3;"
-	txn.exec_prepared0(stm, supervisor, supervisor_id, dev);
-	conn_mtx.unlock();
+	Statement_Registry::exec<Prepareds::DELETE_DEV_EXPERTISE>(txn, supervisor, supervisor_id, dev);
 }
 
 void sql_handler::insert_devedit_session(const std::string& dev, int64_t msg_id, int64_t channel_id) {
-	const std::string& stm = prepared_statements[Prepareds::INSERT_DEVEDIT_SESSION].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 	
 	//"INSERT INTO devedit_sessions(dev_username, managing_msg, msg_channel) \
-	  VALUES($1, $2, $3);"
-	txn.exec_prepared0(stm, dev, msg_id, channel_id);
-	conn_mtx.unlock();
+	  VALUES($1, $2::BIGINT, $3::BIGINT);"
+	Statement_Registry::exec<Prepareds::INSERT_DEVEDIT_SESSION>(txn, dev, msg_id, channel_id);
 }
 void sql_handler::delete_devedit_session(const std::string& dev) {
-	const std::string& stm = prepared_statements[Prepareds::DELETE_DEVEDIT_SESSION].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
 	//"DELETE FROM devedit_sessions WHERE dev_username = $1;"
-	txn.exec_prepared0(stm, dev);
-	conn_mtx.unlock();
+	Statement_Registry::exec<Prepareds::DELETE_DEVEDIT_SESSION>(txn, dev);
 }
 
 std::string sql_handler::get_sticky_id(const std::string& thread_id) {
-	const std::string& stm = prepared_statements[Prepareds::GET_STICKY_ID].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
 	//"SELECT Sticky_ID FROM threads WHERE thread_id = $1::CHARACTER(7) LIMIT 1;
-	pqxx::result r{ txn.exec_prepared(stm, thread_id) };
-	conn_mtx.unlock();
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_STICKY_ID>(txn, thread_id) };
 
 	return r.empty() ? "" : r[0][0].as<std::string>();
 }
 
 bool sql_handler::check_comment_existence(const std::string& comment_id) {
-	const std::string& stm = prepared_statements[Prepareds::CHECK_COMMENT_EXIST].name;
+	switch(_comment_index.lookup(comment_id)) {
+	case Comment_Index::Lookup::SEEN:
+		return true;
+	case Comment_Index::Lookup::NOT_SEEN:
+		return false;
+	default:
+		break;
+	}
 
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	//"SELECT EXISTS(SELECT 1 FROM comments AS a LEFT JOIN approval_queue AS b ON a.comment_id = b.comment_id WHERE a.comment_id = $1);"
-	pqxx::result r{ txn.exec_prepared(stm, comment_id) };
-	conn_mtx.unlock();
+	//"SELECT EXISTS(SELECT 1 FROM comments WHERE comment_id = $1) OR EXISTS(SELECT 1 FROM comments_archive WHERE Comment_ID = $1);"
+	pqxx::result r{ Statement_Registry::exec<Prepareds::CHECK_COMMENT_EXIST>(txn, comment_id) };
 
-	return r[0][0].as<bool>();
+	const bool exists = r[0][0].as<bool>();
+	if(exists) {
+		_comment_index.insert(comment_id);
+	}
+
+	return exists;
 }
-std::vector<sql_handler::Comment_Response> sql_handler::get_comments_in_thread(const std::string& thread_id) {
-	const std::string& stm = prepared_statements[Prepareds::GET_OTHER_COMMENTS].name;
+void sql_handler::warm_comment_index(int recent_days) {
+	//dev_stats already counts hot & archived rows, so the Bloom filter is sized without a pass over the history
+	const int total = get_total_pinned().first;
+	_comment_index.reset(static_cast<std::size_t>(std::max(total, 0)));
+
+	//Keyset pages by Comment_ID - only one page is ever held, however long the history
+	std::size_t loaded = 0;
+	std::string last_comment_id;
+	std::size_t page_rows = 0;
+	do {
+		Connection_Pool::Lease conn = _pool->acquire();
+		pqxx::nontransaction txn{*conn};
+
+		/*SELECT Comment_ID, Post_Epoch > EXTRACT(EPOCH FROM CURRENT_DATE - $1::SMALLINT) FROM comments
+		WHERE Comment_ID > $2 ORDER BY Comment_ID LIMIT $3::INTEGER;*/
+		const pqxx::result r{ Statement_Registry::exec<Prepareds::COMMENT_ID_PAGE>(txn, recent_days, last_comment_id, comment_index_page_size) };
+		for(const auto& row : r) {
+			auto [comment_id, recent] = Statement_Registry::read<Prepareds::COMMENT_ID_PAGE>(row);
+			_comment_index.insert(comment_id, recent);
+			last_comment_id = std::move(comment_id);
+		}
+		page_rows = r.size();
+		loaded += page_rows;
+	} while(page_rows == static_cast<std::size_t>(comment_index_page_size));
+
+	//Archived IDs only go into the Bloom filter - they still count as seen
+	last_comment_id.clear();
+	do {
+		Connection_Pool::Lease conn = _pool->acquire();
+		pqxx::nontransaction txn{*conn};
+
+		//"SELECT Comment_ID FROM comments_archive WHERE Comment_ID > $1 ORDER BY Comment_ID LIMIT $2::INTEGER;"
+		const pqxx::result r{ Statement_Registry::exec<Prepareds::ARCHIVED_COMMENT_ID_PAGE>(txn, last_comment_id, comment_index_page_size) };
+		for(const auto& row : r) {
+			auto [comment_id] = Statement_Registry::read<Prepareds::ARCHIVED_COMMENT_ID_PAGE>(row);
+			_comment_index.insert(comment_id, false);
+			last_comment_id = std::move(comment_id);
+		}
+		page_rows = r.size();
+		loaded += page_rows;
+	} while(page_rows == static_cast<std::size_t>(comment_index_page_size));
 
-	conn_mtx.lock();
+	//Lookups fall through to the database until every page is in
+	_comment_index.mark_ready();
+
+	spdlog::info("SQL: Comment index warmed with {} IDs ({} recent, sized for {})", loaded, _comment_index.recent_size(), total);
+}
+std::vector<sql_handler::Comment_Response> sql_handler::get_comments_in_thread(const std::string& thread_id) {
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
 	//"SELECT Comment_ID, Thread_ID, Dev_Username, Post_Epoch, Comment_Text FROM comments WHERE thread_id = $1::CHARACTER(7) AND status = true ORDER BY Post_Epoch DESC;"
-	pqxx::result r{ txn.exec_prepared(stm, thread_id) };
-	conn_mtx.unlock();
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_OTHER_COMMENTS>(txn, thread_id) };
 
 	std::vector<sql_handler::Comment_Response> res;
 	res.reserve(r.size());
 
     for(const auto& row : r) {
-		sql_handler::Comment_Response current_row;
-		current_row.comment_id = row[0].as<std::string>();
-		current_row.thread_id = row[1].as<std::string>();
-		current_row.author = row[2].as<std::string>();
-		current_row.epoch_time = row[3].as<int64_t>();
-		current_row.comment_text = row[4].as<std::string>();
-
-		res.emplace_back(current_row);
+		res.emplace_back(Statement_Registry::decode<Comment_Response, Prepareds::GET_OTHER_COMMENTS>(row));
     }   
 	
 	return res;
 }
+std::shared_ptr<const sql_handler::Thread_Snapshot> sql_handler::get_thread_snapshot(const std::string& thread_id) {
+	if(const auto cached = _thread_cache.get(thread_id)) {
+		return *cached;
+	}
 
-std::vector<std::string> sql_handler::get_thread_ids_by_date(int days) {
-	const std::string& stm = prepared_statements[Prepareds::GET_THREAD_IDS_BY_DATE].name;
-
-	conn_mtx.lock();
+	const uint64_t generation = _thread_cache_generation.load();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	//"SELECT DISTINCT Thread_ID FROM comments WHERE Timestamp > CURRENT_DATE - $1::SMALLINT AND STATUS = TRUE ORDER BY Post_Epoch DESC LIMIT 1000;
-	pqxx::result r{ txn.exec_prepared(stm, days) };
-	conn_mtx.unlock();
+	/*SELECT t.Sticky_ID, c.Comment_ID, c.Dev_Username, c.Post_Epoch, c.Comment_Text, x.Comment_Text, t.Body_Digest
+	FROM (SELECT 1) AS q
+	LEFT JOIN threads AS t ON t.Thread_ID = $1
+	LEFT JOIN comments AS c ON c.Thread_ID = $1 AND c.Status = 1
+	LEFT JOIN LATERAL (SELECT Comment_Text FROM contexts WHERE Owner_Comment_ID = c.Comment_ID AND Status = true LIMIT 1) AS x ON true
+	ORDER BY c.Post_Epoch DESC;*/
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_THREAD_SNAPSHOT>(txn, thread_id) };
 
-	std::vector<std::string> res;
-	res.reserve(r.size());
+	std::shared_ptr<Thread_Snapshot> res = std::make_shared<Thread_Snapshot>();
+	res->comments.reserve(r.size());
 
-	for (const auto& row : r) {
-		res.emplace_back(row[0].as<std::string>());
+	for(const auto& row : r) {
+		auto [sticky_id, comment_id, author, epoch_time, comment_text, context, body_digest] = Statement_Registry::read<Prepareds::GET_THREAD_SNAPSHOT>(row);
+		if(sticky_id) {
+			res->sticky_id = std::move(*sticky_id);
+		}
+		res->body_digest = body_digest;
+		if(!comment_id) {
+			continue;
+		}
+
+		if(context) {
+			res->contexts.emplace(*comment_id, std::move(*context));
+		}
+		res->comments.push_back({ std::move(*comment_id), thread_id, std::move(*author), *epoch_time, std::move(*comment_text) });
+	}
+
+	std::lock_guard<std::mutex> lock(_thread_cache_write_mtx);
+	if(_thread_cache_generation.load() == generation) {
+		_thread_cache.put(thread_id, res);
 	}
 
 	return res;
 }
-std::vector<std::string> sql_handler::get_comment_ids_by_date(int days) {
-	const std::string& stm = prepared_statements[Prepareds::GET_COMMENT_IDS_BY_DATE].name;
-
-	conn_mtx.lock();
-	pqxx::nontransaction txn{*conn};
 
-	//"SELECT Comment_ID FROM comments WHERE Timestamp > CURRENT_DATE - $1::SMALLINT AND STATUS = TRUE ORDER BY Post_Epoch DESC LIMIT 1000;
-	pqxx::result r{ txn.exec_prepared(stm, days) };
-	conn_mtx.unlock();
-
-	std::vector<std::string> res;
-	res.reserve(r.size());
-	
-	for (const auto& row : r) {
-		res.emplace_back(row[0].as<std::string>());
-	}
+void sql_handler::for_each_thread_id_page(int days, int page_size, const std::function<void(const std::vector<std::string>&)>& on_page) {
+	//Resumes strictly after the last (Timestamp, Thread_ID) seen - 'infinity' opens the first page
+	std::string last_timestamp = "infinity";
+	std::string last_thread_id;
+
+	std::vector<std::string> page;
+	page.reserve(page_size);
+
+	do {
+		page.clear();
+		{
+			Connection_Pool::Lease conn = _pool->acquire();
+			pqxx::nontransaction txn{*conn};
+
+			/*SELECT Thread_ID, Timestamp::TEXT FROM threads WHERE Timestamp > CURRENT_DATE - $1::SMALLINT
+			AND (Timestamp, Thread_ID) < ($2::TIMESTAMPTZ, $3) ORDER BY Timestamp DESC, Thread_ID DESC LIMIT $4::INTEGER;*/
+			pqxx::result r{ Statement_Registry::exec<Prepareds::THREAD_ID_PAGE_BY_DATE>(txn, days, last_timestamp, last_thread_id, page_size) };
+
+			for(const auto& row : r) {
+				auto [thread_id, timestamp] = Statement_Registry::read<Prepareds::THREAD_ID_PAGE_BY_DATE>(row);
+				last_timestamp = std::move(timestamp);
+				page.emplace_back(std::move(thread_id));
+			}
+		}
+		if(page.empty()) {
+			break;
+		}
+		last_thread_id = page.back();
 
-	return res;
+		on_page(page);
+	} while(static_cast<int>(page.size()) == page_size);
 }
 std::vector<std::string> sql_handler::get_comment_ids_by_thread_id(const std::string& thread_id) {
-	const std::string& stm = prepared_statements[Prepareds::GET_COMMENT_IDS_BY_THREAD].name;
-
-	conn_mtx.lock();
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 	
 	//"SELECT Comment_ID FROM comments WHERE Thread_ID = $1::CHAR(6) AND Status = TRUE ORDER BY Post_Epoch DESC;"
-	pqxx::result r{ txn.exec_prepared(stm, thread_id) };
-	conn_mtx.unlock();
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_COMMENT_IDS_BY_THREAD>(txn, thread_id) };
 
 	std::vector<std::string> res;
 	res.reserve(r.size());
@@ -581,58 +1091,339 @@ std::vector<std::string> sql_handler::get_comment_ids_by_thread_id(const std::st
 
 	return res;
 }
-std::map<std::string, int64_t> sql_handler::get_comment_id_epoch_pair_by_date(int days) {
-	const std::string& stm = prepared_statements[Prepareds::COMMENT_EPOCH_PAIRS_BY_DATE].name;
+void sql_handler::for_each_comment_epoch_page(int days, int page_size, const std::function<void(const Comment_Epoch_Page&)>& on_page) {
+	//Resumes strictly after the last (Post_Epoch, Comment_ID) seen
+	int64_t last_epoch = std::numeric_limits<int64_t>::max();
+	std::string last_comment_id;
+
+	Comment_Epoch_Page page;
+	page.reserve(page_size);
+
+	do {
+		page.clear();
+		{
+			Connection_Pool::Lease conn = _pool->acquire();
+			pqxx::nontransaction txn{*conn};
+
+			/*SELECT Comment_ID, Post_Epoch FROM comments WHERE Status = 1 AND Timestamp > CURRENT_DATE - $1::SMALLINT
+			AND (Post_Epoch, Comment_ID) < ($2::BIGINT, $3) ORDER BY Post_Epoch DESC, Comment_ID DESC LIMIT $4::INTEGER;*/
+			pqxx::result r{ Statement_Registry::exec<Prepareds::COMMENT_EPOCH_PAGE_BY_DATE>(txn, days, last_epoch, last_comment_id, page_size) };
+
+			for(const auto& row : r) {
+				auto [comment_id, post_epoch] = Statement_Registry::read<Prepareds::COMMENT_EPOCH_PAGE_BY_DATE>(row);
+				page.emplace_back(std::move(comment_id), post_epoch);
+			}
+		}
+		if(page.empty()) {
+			break;
+		}
+		last_comment_id = page.back().first;
+		last_epoch = page.back().second;
 
-	conn_mtx.lock();
+		//The lease is already back in the pool, so slow per-page work never pins a connection
+		on_page(page);
+	} while(static_cast<int>(page.size()) == page_size);
+}
+std::map<std::string, int64_t> sql_handler::get_comment_id_epoch_pair_by_thread_id(const std::string& thread_id) {
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	//"SELECT Comment_ID, Post_Epoch FROM comments WHERE Timestamp > CURRENT_DATE - $1::SMALLINT AND STATUS = TRUE ORDER BY Post_Epoch DESC LIMIT 1000;"
-	pqxx::result r{ txn.exec_prepared(stm, days) };
-	conn_mtx.unlock();
+	//"SELECT Comment_ID, Post_Epoch FROM comments WHERE thread_id = $1 AND STATUS = TRUE ORDER BY Post_Epoch DESC;"
+	pqxx::result r{ Statement_Registry::exec<Prepareds::COMMENT_EPOCH_PAIRS_BY_THREAD>(txn, thread_id) };
 
 	std::map<std::string, int64_t> res;
 
 	for (const auto& row : r) {
-		const std::string& comment_id = row[0].as<std::string>();
-		const int64_t post_epoch = row[1].as<int64_t>();
+		auto [comment_id, post_epoch] = Statement_Registry::read<Prepareds::COMMENT_EPOCH_PAIRS_BY_THREAD>(row);
+		res.emplace(std::move(comment_id), post_epoch);
+	}
+
+	return res;
+}
 
-		res.emplace(comment_id, post_epoch);
+sql_handler::Archive_Result sql_handler::archive_cold_threads(int days) {
+	Archive_Result res;
+	{
+		Connection_Pool::Lease conn = _pool->acquire();
+		pqxx::work txn{*conn};
+
+		/*WITH cold AS (SELECT c.Thread_ID FROM comments AS c
+			WHERE NOT EXISTS (SELECT 1 FROM update_queue AS q WHERE q.Thread_ID = c.Thread_ID)
+			GROUP BY c.Thread_ID HAVING MAX(c.Timestamp) < CURRENT_DATE - $1::SMALLINT),
+		moved_contexts AS (DELETE FROM contexts AS x USING cold WHERE x.Thread_ID = cold.Thread_ID RETURNING x.*),
+		archived_contexts AS (INSERT INTO contexts_archive SELECT * FROM moved_contexts RETURNING 1),
+		moved AS (DELETE FROM comments AS c USING cold WHERE c.Thread_ID = cold.Thread_ID RETURNING c.*),
+		archived AS (INSERT INTO comments_archive SELECT * FROM moved RETURNING 1)
+		SELECT (SELECT COUNT(*) FROM archived), (SELECT COUNT(*) FROM archived_contexts);*/
+		pqxx::result r{ Statement_Registry::exec<Prepareds::ARCHIVE_COLD_THREADS>(txn, days) };
+		std::tie(res.comments, res.contexts) = Statement_Registry::read<Prepareds::ARCHIVE_COLD_THREADS>(r[0]);
+
+		//"DELETE FROM contexts AS x WHERE NOT EXISTS (SELECT 1 FROM comments AS c WHERE c.Comment_ID = x.Owner_Comment_ID);"
+		res.orphaned_contexts = Statement_Registry::exec<Prepareds::DROP_ORPHAN_CONTEXTS>(txn).affected_rows();
+
+		txn.commit();
 	}
 
+	//Cached snapshots may hold archived threads - they are rebuilt on the next render
+	std::lock_guard<std::mutex> lock(_thread_cache_write_mtx);
+	++_thread_cache_generation;
+	_thread_cache.clear();
+
 	return res;
 }
-std::map<std::string, int64_t> sql_handler::get_comment_id_epoch_pair_by_thread_id(const std::string& thread_id) {
-	const std::string& stm = prepared_statements[Prepareds::COMMENT_EPOCH_PAIRS_BY_THREAD].name;
+bool sql_handler::restore_archived_thread(const std::string& thread_id) {
+	Connection_Pool::Lease conn = _pool->acquire();
+	pqxx::nontransaction txn{*conn};
 
-	conn_mtx.lock();
+	return restore_archived_thread(txn, thread_id);
+}
+bool sql_handler::restore_archived_comment(const std::string& comment_id) {
+	Connection_Pool::Lease conn = _pool->acquire();
 	pqxx::nontransaction txn{*conn};
 
-	//"SELECT Comment_ID, Post_Epoch FROM comments WHERE thread_id = $1 AND STATUS = TRUE ORDER BY Post_Epoch DESC;"
-	pqxx::result r{ txn.exec_prepared(stm, thread_id) };
-	conn_mtx.unlock();
+	return restore_archived_comment(txn, comment_id);
+}
+bool sql_handler::restore_archived_thread(pqxx::transaction_base& txn, const std::string& thread_id) {
+	/*WITH restored_contexts AS (DELETE FROM contexts_archive WHERE Thread_ID = $1 RETURNING *),
+	back_contexts AS (INSERT INTO contexts SELECT * FROM restored_contexts),
+	restored AS (DELETE FROM comments_archive WHERE Thread_ID = $1 RETURNING *)
+	INSERT INTO comments SELECT * FROM restored;*/
+	pqxx::result r{ Statement_Registry::exec<Prepareds::RESTORE_THREAD>(txn, thread_id) };
+
+	if(r.affected_rows() == 0) {
+		return false;
+	}
+	invalidate_thread(thread_id);
 
-	std::map<std::string, int64_t> res;
+	return true;
+}
+bool sql_handler::restore_archived_comment(pqxx::transaction_base& txn, const std::string& comment_id) {
+	//"SELECT Thread_ID FROM comments_archive WHERE Comment_ID = $1 LIMIT 1;"
+	pqxx::result r{ Statement_Registry::exec<Prepareds::GET_ARCHIVED_THREAD_ID>(txn, comment_id) };
+	if(r.empty()) {
+		return false;
+	}
 
-	for (const auto& row : r) {
-		const std::string& comment_id = row[0].as<std::string>();
-		const int64_t post_epoch = row[1].as<int64_t>();
+	return restore_archived_thread(txn, r[0][0].as<std::string>());
+}
+
+void sql_handler::begin_transaction() {
+	_pool->pin_thread(true);
+
+	try {
+		Connection_Pool::Lease conn = _pool->acquire();
+		pqxx::nontransaction txn{*conn};
+		txn.exec0("BEGIN TRANSACTION;");
+	}
+	catch(...) {
+		_pool->unpin_thread(true);
+		throw;
+	}
+	++transaction_depth;
+}
+void sql_handler::commit_transaction() {
+	{
+		Connection_Pool::Lease conn = _pool->acquire();
+		pqxx::nontransaction txn{*conn};
+		txn.exec0("COMMIT TRANSACTION;");
+	}
+	_pool->unpin_thread(true);
+	--transaction_depth;
+
+	for(const auto& comment_id : uncommitted_comment_ids) {
+		_comment_index.insert(comment_id);
+	}
+	uncommitted_comment_ids.clear();
+
+	const std::vector<std::string> thread_ids = std::move(uncommitted_thread_ids);
+	uncommitted_thread_ids.clear();
+	for(const auto& thread_id : thread_ids) {
+		invalidate_thread(thread_id);
+	}
+
+	//Moved out first - the listener runs outside the transaction & may call back into the handler
+	const std::vector<Dev_Stats_Delta> dev_stats = std::move(uncommitted_dev_stats);
+	uncommitted_dev_stats.clear();
+	for(const auto& delta : dev_stats) {
+		_dev_stats_listener(delta.dev, delta.total_delta, delta.pinned_delta);
+	}
+}
+void sql_handler::rollback_transaction() {
+	try {
+		Connection_Pool::Lease conn = _pool->acquire();
+		pqxx::nontransaction txn{*conn};
+		txn.exec0("ROLLBACK TRANSACTION;");
+	}
+	catch(const pqxx::failure& e) {
+		spdlog::error("SQL: Rollback failed - {}", e.what());
+	}
+	_pool->unpin_thread(true);
+	transaction_depth = std::max(transaction_depth - 1, 0);
+
+	uncommitted_comment_ids.clear();
+	uncommitted_dev_stats.clear();
+	uncommitted_thread_ids.clear();
+}
+
+std::unique_ptr<Update_Listener> sql_handler::listen_for_updates(Update_Listener::Notify_Function on_enqueue) {
+	return std::make_unique<Update_Listener>(_connection_string, _update_channel, std::move(on_enqueue));
+}
+
+void sql_handler::reserve_thread_connection() {
+	_pool->pin_thread();
+}
+void sql_handler::release_thread_connection() {
+	_pool->unpin_thread();
+}
+
+Connection_Pool::Stats sql_handler::get_pool_stats() {
+	return _pool->get_stats();
+}
 
-		res.emplace(comment_id, post_epoch);
+void sql_handler::Write_Batch::update_comment(const std::string& comment_id, const std::string& text, int64_t modified_epoch) {
+	_entries.push_back({ Batch_Write::UPDATE_COMMENT, Prepareds::UPDATE_COMMENT, { text, std::to_string(modified_epoch), comment_id } });
+}
+void sql_handler::Write_Batch::delete_comment(const std::string& comment_id) {
+	_entries.push_back({ Batch_Write::DELETE_COMMENT, Prepareds::DELETE_COMMENT, { comment_id } });
+}
+void sql_handler::Write_Batch::enqueue_update(const std::string& thread_id) {
+	_entries.push_back({ Batch_Write::ENQUEUE_UPDATE, Prepareds::ENQUEUE_UPDATE, { thread_id } });
+}
+std::size_t sql_handler::Write_Batch::size() const {
+	return _entries.size();
+}
+bool sql_handler::Write_Batch::empty() const {
+	return _entries.empty();
+}
+
+std::string sql_handler::batch_query(const pqxx::transaction_base& txn, const Write_Batch::Entry& entry) {
+	//EXECUTE "Name"('text', '123', ...); - pqxx::pipeline only takes query text, so the protocol-level prepared
+	//statement is reached through SQL EXECUTE. Every argument goes through libpq's connection-aware quoting as an
+	//untyped literal the prepared parameter type then casts, so nothing is ever spliced into the text unquoted
+	std::string query = "EXECUTE " + txn.quote_name(Statement_Registry::get(entry.statement).name) + "(";
+	for(std::size_t i = 0; i < entry.params.size(); ++i) {
+		query += (i == 0 ? "" : ", ");
+		query += txn.quote(entry.params[i]);
+	}
+	query += ");";
+
+	return query;
+}
+void sql_handler::apply_batch_result(const Write_Batch::Entry& entry, const pqxx::result& r) {
+	if(entry.statement == Prepareds::UPDATE_COMMENT) {
+		for(const auto& row : r) {
+			invalidate_thread(row[0].as<std::string>());
+		}
+	}
+	else if(entry.statement == Prepareds::DELETE_COMMENT) {
+		const std::string& comment_id = entry.params[0];
+
+		_comment_index.erase(comment_id);
+		for(const auto& row : r) {
+			notify_dev_stats(row[0].as<std::string>(), -1, row[1].as<int>() == 1 ? -1 : 0);
+			remove_from_thread(row[2].as<std::string>(), comment_id);
+		}
+	}
+}
+std::vector<sql_handler::Batch_Result> sql_handler::execute_batch(const Write_Batch& batch) {
+	std::vector<Batch_Result> res(batch._entries.size());
+	if(batch._entries.empty()) {
+		return res;
+	}
+	for(std::size_t i = 0; i < batch._entries.size(); ++i) {
+		res[i].write = batch._entries[i].write;
+	}
+
+	Connection_Pool::Lease conn = _pool->acquire();
+
+	//Fast path - every statement goes out in one pipelined flush & commits together
+	try {
+		pqxx::work txn{*conn};
+		pqxx::pipeline pipe{txn};
+
+		std::vector<pqxx::pipeline::query_id> query_ids;
+		query_ids.reserve(batch._entries.size());
+		for(const auto& entry : batch._entries) {
+			query_ids.emplace_back(pipe.insert(batch_query(txn, entry)));
+		}
+		std::vector<pqxx::result> results;
+		results.reserve(query_ids.size());
+		for(std::size_t i = 0; i < query_ids.size(); ++i) {
+			results.emplace_back(pipe.retrieve(query_ids[i]));
+			res[i].success = true;
+			res[i].affected_rows = results.back().affected_rows();
+		}
+		pipe.complete();
+		txn.commit();
+
+		for(std::size_t i = 0; i < results.size(); ++i) {
+			apply_batch_result(batch._entries[i], results[i]);
+		}
+		return res;
+	}
+	catch(const pqxx::sql_error& e) {
+		spdlog::warn("SQL: Pipelined batch of {} statements rolled back, replaying individually - {}", batch._entries.size(), e.what());
+	}
+
+	//Slow path - one failing statement shouldn't take the rest of the batch down with it
+	for(std::size_t i = 0; i < batch._entries.size(); ++i) {
+		const Write_Batch::Entry& entry = batch._entries[i];
+		try {
+			pqxx::nontransaction txn{*conn};
+			const pqxx::result r{ txn.exec(batch_query(txn, entry)) };
+			res[i].success = true;
+			res[i].affected_rows = static_cast<int>(r.affected_rows());
+			apply_batch_result(entry, r);
+		}
+		catch(const pqxx::sql_error& e) {
+			res[i].success = false;
+			res[i].affected_rows = 0;
+			res[i].error = e.what();
+			spdlog::error("SQL: Batched {} failed - {}", Statement_Registry::get(entry.statement).name, e.what());
+		}
 	}
 
 	return res;
 }
 
-void sql_handler::begin_transaction() {
-	conn_mtx.lock();
-	pqxx::nontransaction txn{*conn};
-	txn.exec0("BEGIN TRANSACTION;");
-	conn_mtx.unlock();
+void sql_handler::invalidate_thread(const std::string& thread_id) {
+	if(transaction_depth > 0) {
+		uncommitted_thread_ids.emplace_back(thread_id);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_thread_cache_write_mtx);
+
+	++_thread_cache_generation;
+	_thread_cache.erase(thread_id);
 }
-void sql_handler::commit_transaction() {
-	conn_mtx.lock();
-	pqxx::nontransaction txn{*conn};
-	txn.exec0("COMMIT TRANSACTION;");
-	conn_mtx.unlock();
+void sql_handler::patch_thread(const std::string& thread_id, const std::function<void(Thread_Snapshot&)>& patch) {
+	//Patching needs the committed rows too, so inside a transaction the entry is just dropped at COMMIT
+	if(transaction_depth > 0) {
+		uncommitted_thread_ids.emplace_back(thread_id);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_thread_cache_write_mtx);
+
+	++_thread_cache_generation;
+
+	const auto cached = _thread_cache.get(thread_id);
+	if(!cached) {
+		return;
+	}
+
+	//Snapshots are shared with readers, so patches are applied to a copy & swapped in
+	std::shared_ptr<Thread_Snapshot> patched = std::make_shared<Thread_Snapshot>(**cached);
+	patch(*patched);
+	_thread_cache.put(thread_id, std::move(patched));
+}
+void sql_handler::remove_from_thread(const std::string& thread_id, const std::string& comment_id) {
+	patch_thread(thread_id, [&comment_id](Thread_Snapshot& snapshot) {
+		std::vector<Comment_Response>& comments = snapshot.comments;
+		comments.erase(std::remove_if(comments.begin(), comments.end(), [&comment_id](const Comment_Response& comment) {
+			return comment.comment_id == comment_id;
+		}), comments.end());
+		snapshot.contexts.erase(comment_id);
+	});
 }
@@ -0,0 +1,137 @@
+#include "trackerbot/target_registry.h"
+
+#include "trackerbot/types.h"
+#include "trackerbot/username_interner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+const Target* Target_Registry::Table::find(Username_Interner::Id id) const {
+	if(id >= targets.size() || targets[id].data == nullptr) {
+		return nullptr;
+	}
+
+	return &targets[id];
+}
+
+Target_Registry::Target_Registry()
+	: _table(std::make_shared<const Table>())
+{
+}
+
+std::shared_ptr<const Target_Registry::Table> Target_Registry::snapshot() const {
+	return std::atomic_load_explicit(&_table, std::memory_order_acquire);
+}
+Target Target_Registry::find(std::string_view username) const {
+	const Username_Interner::Id id = _usernames.find(username);
+	if(id == Username_Interner::invalid_id) {
+		return Target();
+	}
+
+	const std::shared_ptr<const Table> table = snapshot();
+	const Target* target = table->find(id);
+
+	return target ? *target : Target();
+}
+Username_Interner::Id Target_Registry::id_of(std::string_view username) const {
+	return _usernames.find(username);
+}
+
+void Target_Registry::assign(const std::vector<Target>& targets) {
+	std::vector<Target> next;
+	std::size_t tracked = 0;
+	for(const Target& target : targets) {
+		const Username_Interner::Id id = _usernames.intern(target.data->username);
+		if(id >= next.size()) {
+			next.resize(id + 1);
+		}
+		//Usernames differing only in case collapse to the first one, as they always did
+		if(next[id].data == nullptr) {
+			next[id] = target;
+			ensure_stats(next[id]);
+			++tracked;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(_writer_mtx);
+	publish(*snapshot(), std::move(next), tracked);
+}
+void Target_Registry::emplace(const Target& target) {
+	const Username_Interner::Id id = _usernames.intern(target.data->username);
+
+	std::lock_guard<std::mutex> lock(_writer_mtx);
+	const std::shared_ptr<const Table> current = snapshot();
+	if(current->find(id) != nullptr) {
+		return;
+	}
+
+	std::vector<Target> next(current->targets);
+	next.resize(std::max<std::size_t>(next.size(), id + 1));
+	next[id] = target;
+	ensure_stats(next[id]);
+	publish(*current, std::move(next), current->tracked + 1);
+}
+void Target_Registry::remove(std::string_view username) {
+	const Username_Interner::Id id = _usernames.find(username);
+
+	std::lock_guard<std::mutex> lock(_writer_mtx);
+	const std::shared_ptr<const Table> current = snapshot();
+	if(current->find(id) == nullptr) {
+		return;
+	}
+
+	std::vector<Target> next(current->targets);
+	next[id] = Target();
+	publish(*current, std::move(next), current->tracked - 1);
+}
+Target Target_Registry::update(std::string_view username, const Modifier& modify) {
+	const Username_Interner::Id id = _usernames.find(username);
+
+	std::lock_guard<std::mutex> lock(_writer_mtx);
+	const std::shared_ptr<const Table> current = snapshot();
+	const Target* target = current->find(id);
+	if(target == nullptr) {
+		return Target();
+	}
+
+	auto data = std::make_shared<Target::Data>(*target->data);
+	modify(*data);
+	const Target updated{ std::move(data), target->stats };
+
+	std::vector<Target> next(current->targets);
+	next[id] = updated;
+	publish(*current, std::move(next), current->tracked);
+
+	return updated;
+}
+
+void Target_Registry::add_stats(Username_Interner::Id id, int total_delta, int pinned_delta) const {
+	const std::shared_ptr<const Table> table = snapshot();
+	const Target* target = table->find(id);
+	if(target == nullptr) {
+		return;
+	}
+
+	target->stats->dev_total.fetch_add(total_delta, std::memory_order_relaxed);
+	target->stats->dev_pinned.fetch_add(pinned_delta, std::memory_order_relaxed);
+}
+
+void Target_Registry::publish(const Table& current, std::vector<Target> targets, std::size_t tracked) {
+	auto next = std::make_shared<Table>();
+	next->version = current.version + 1;
+	next->targets = std::move(targets);
+	next->tracked = tracked;
+
+	std::atomic_store_explicit(&_table, std::shared_ptr<const Table>(std::move(next)), std::memory_order_release);
+}
+void Target_Registry::ensure_stats(Target& target) {
+	if(target.stats == nullptr) {
+		target.stats = std::make_shared<Target::Stats>();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "trackerbot/task_executor.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+Task_Executor::Task_Executor(std::string name, int worker_count)
+	: _name(std::move(name))
+{
+	worker_count = std::max(worker_count, 1);
+
+	_workers.reserve(worker_count);
+	for(int i = 0; i < worker_count; ++i) {
+		_workers.emplace_back(&Task_Executor::worker_loop, this);
+	}
+}
+Task_Executor::~Task_Executor() {
+	{
+		std::lock_guard<std::mutex> lock(_queue_mtx);
+		_stopping = true;
+	}
+	_queue_cv.notify_all();
+
+	for(auto& worker : _workers) {
+		if(worker.joinable()) {
+			worker.join();
+		}
+	}
+}
+
+void Task_Executor::post(Task task, Error_Callback on_error) {
+	{
+		std::lock_guard<std::mutex> lock(_queue_mtx);
+		if(_stopping) {
+			throw std::runtime_error(_name + " executor is shutting down.");
+		}
+		_jobs.push_back({ std::move(task), std::move(on_error) });
+	}
+	_queue_cv.notify_one();
+}
+std::size_t Task_Executor::pending() {
+	std::lock_guard<std::mutex> lock(_queue_mtx);
+	return _jobs.size();
+}
+
+void Task_Executor::worker_loop() {
+	while(true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(_queue_mtx);
+			_queue_cv.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+			//Drain what was already queued before shutting down
+			if(_jobs.empty()) {
+				break;
+			}
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+		}
+
+		try {
+			job.task();
+		}
+		catch(...) {
+			report_error(job.on_error, std::current_exception());
+		}
+	}
+}
+
+void Task_Executor::report_error(const Error_Callback& on_error, std::exception_ptr error) const {
+	if(on_error) {
+		try {
+			on_error(error);
+		}
+		catch(const std::exception& e) {
+			spdlog::error("{}: Error callback threw - {}", _name, e.what());
+		}
+		return;
+	}
+
+	try {
+		std::rethrow_exception(error);
+	}
+	catch(const std::exception& e) {
+		spdlog::error("{}: Task failed - {}", _name, e.what());
+	}
+	catch(...) {
+		spdlog::error("{}: Task failed with an unknown error", _name);
+	}
+}
\ No newline at end of file
@@ -1,7 +1,13 @@
 #include "trackerbot/tracker.h"
 
+#include "trackerbot/async_sql.h"
+#include "trackerbot/comment_index.h"
+#include "trackerbot/edit_scheduler.h"
+#include "trackerbot/info_fetcher.h"
 #include "trackerbot/trackercfg.h"
 #include "trackerbot/sql.h"
+#include "trackerbot/startup_timer.h"
+#include "trackerbot/task_executor.h"
 #include "trackerbot/utility.h"
 
 #include <dpp/dpp.h>
@@ -9,9 +15,17 @@
 #include <redditcpp/api.h>
 
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <exception>
 #include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 Tracker::Tracker(dpp::cluster* bot, std::unique_ptr<TrackerConfig> cfg_handler) 
     : _bot(bot)
@@ -22,11 +36,7 @@ Tracker::Tracker(dpp::cluster* bot, std::unique_ptr<TrackerConfig> cfg_handler)
     _discord_config = _cfg_handler->get_discord_config();
     _sql_config = _cfg_handler->get_sql_config();
     _format_config = _cfg_handler->get_format_config();
-
-    const std::string target_sub = _tracker_config.target_subreddit;
-    const std::string admin_creds = _sql_config.admin_credentials;
-    const std::string conn_string = _sql_config.conn_string;
-    _sql = std::make_shared<sql_handler>(target_sub, admin_creds, conn_string);
+    _format_version = format_version(_format_config);
 
     const TrackerConfig::Reddit_Config reddit_cfg = _cfg_handler->get_reddit_config();
     reddit::AuthInfo oa2info {
@@ -34,22 +44,94 @@ Tracker::Tracker(dpp::cluster* bot, std::unique_ptr<TrackerConfig> cfg_handler)
         reddit_cfg.scope, "permanent", reddit_cfg.user_agent
     };
     _reddit_api = std::make_shared<reddit::Api>(oa2info, spdlog::level::debug);
-
-    if(reddit_cfg.refresh_token.empty()) {
-        _reddit_api->authenticate(_reddit_api->browser_get_token(), true);
+    _reddit_limiter = std::make_unique<Rate_Limiter>(_tracker_config.reddit_requests_per_minute, _tracker_config.reddit_burst);
+    _info_fetcher = std::make_unique<Info_Fetcher>(_reddit_api, *_reddit_limiter, reddit_info_concurrency);
+    _update_coalescer = std::make_unique<Update_Coalescer>(std::chrono::seconds(_tracker_config.sticky_debounce),
+        std::chrono::seconds(_tracker_config.sticky_max_delay), update_coalescer_capacity);
+    _reddit_tasks = std::make_unique<Task_Executor>("Reddit tasks", 1);
+}
+void Tracker::begin_startup() {
+    _startup = std::async(std::launch::async, [this]() { startup(); }).share();
+}
+bool Tracker::wait_until_ready() {
+    try {
+        _startup.get();
     }
-    else {
-        _reddit_api->refresh_auth(reddit_cfg.refresh_token, true);
+    catch(const std::exception& e) {
+        spdlog::critical("Tracker: Startup failed - {}", e.what());
+        return false;
     }
-    
-    const std::unordered_map<std::string, Target> devmap = _sql->get_dev_map();
-    _cfg_handler->target_map_reserve(devmap.size());
-    for(const auto& itr : devmap) {
-        _cfg_handler->target_map_emplace(itr.second);
+
+    return true;
+}
+bool Tracker::is_ready() const {
+    return _ready;
+}
+void Tracker::startup() {
+    Startup_Timer timer;
+
+    //Reddit auth only needs the network, so it runs alongside the whole SQL side
+    std::future<void> reddit_auth = std::async(std::launch::async, [this, &timer]() {
+        timer.time("Reddit auth", [this]() {
+            const TrackerConfig::Reddit_Config reddit_cfg = _cfg_handler->get_reddit_config();
+            if(reddit_cfg.refresh_token.empty()) {
+                _reddit_api->authenticate(_reddit_api->browser_get_token(), true);
+            }
+            else {
+                _reddit_api->refresh_auth(reddit_cfg.refresh_token, true);
+            }
+        });
+    });
+
+    const std::string target_sub = _tracker_config.target_subreddit;
+    const std::string admin_creds = _sql_config.admin_credentials;
+    const std::string conn_string = _sql_config.conn_string;
+    //The executor's workers each hold a connection of their own on top of the shared pool
+    _sql = std::make_shared<sql_handler>(target_sub, admin_creds, conn_string, _sql_config.pool_size + _sql_config.async_workers, &timer);
+    _async_sql = std::make_unique<Async_SQL>(_sql, _sql_config.async_workers);
+    _sql->set_dev_stats_listener(
+        [this](std::string_view dev) { return _cfg_handler->target_map_id_of(dev); },
+        [this](Username_Interner::Id dev, int total_delta, int pinned_delta) {
+            _cfg_handler->target_map_add_stats(dev, total_delta, pinned_delta);
+        });
+
+    std::future<std::unordered_map<std::string, Target>> devmap = std::async(std::launch::async, [this, &timer]() {
+        return timer.time("Dev map load", [this]() { return _sql->get_dev_map(); });
+    });
+    timer.time("Comment index warmup", [this]() { _sql->warm_comment_index(_tracker_config.update_day_limit); });
+    _friends_feed_mark = _sql->get_tracker_state(friends_feed_mark_key);
+    //The mark & the existence check skip anything already stored, so approvals a crash cut short only come back from here
+    for(sql_handler::Pending_Approval& pending : _sql->get_pending_approvals()) {
+        const sql_handler::Status_Change change{ pending.thread_id, pending.dev, 0, pending.created_epoch, std::move(pending.comment_text) };
+        _recovered_approvals.push_back({ stored_comment(pending.comment_id, change), static_cast<Target::Status>(pending.status) });
+    }
+    if(!_recovered_approvals.empty()) {
+        spdlog::info("Tracker: Recovered {} pending approvals", _recovered_approvals.size());
     }
+
+    _cfg_handler->target_map_assign(devmap.get());
+
+    reddit_auth.get();
+
+    spdlog::info("Tracker: Ready in {}ms - {}", timer.total_ms(), timer.summary());
+    _ready = true;
 }
 Tracker::~Tracker() {
-    _tracker_on_flag = false;
+    //Startup touches most members, so it has to finish before any of them go away
+    if(_startup.valid()) {
+        _startup.wait();
+    }
+    _force_update_cancel = true;
+    {
+        std::lock_guard<std::mutex> lock(_force_update_mtx);
+        if(_force_update_job.valid()) {
+            _force_update_job.wait();
+        }
+    }
+    stop_stages();
+    //Async SQL callbacks hand work to the Reddit executor, so its workers go first & the executor drains after them
+    _async_sql.reset();
+    _reddit_tasks.reset();
     _bot = nullptr;
 }
 
@@ -150,10 +232,18 @@ std::string Tracker::preformat_sticky_comment(const std::string& author, const s
 
     return generate_sticky_comment(author, url, epoch_time, trimmed_comment);
 }
-std::string Tracker::construct_comments(const std::string& thread_id) {
+uint64_t Tracker::format_version(const TrackerConfig::Format_Config& format) {
+    uint64_t res = Utility::fnv1a_hash(std::to_string(format.total_char_limit) + ":" + std::to_string(format.context_char_limit));
+    for(const std::string* field : { &format.entry, &format.entry_wexpertise, &format.context, &format.comment }) {
+        res = Utility::fnv1a_hash(*field, Utility::fnv1a_hash("\x1f", res));
+    }
+
+    return res;
+}
+std::string Tracker::construct_comments(const sql_handler::Thread_Snapshot& snapshot) {
     const std::string target_subreddit = _tracker_config.target_subreddit;
-    const std::vector<sql_handler::Comment_Response> other_comments = _sql->get_comments_in_thread(thread_id);
-    const std::unordered_map<std::string, std::string> contexts = _sql->get_contexts_for_thread(thread_id);
+    const std::vector<sql_handler::Comment_Response>& other_comments = snapshot.comments;
+    const std::unordered_map<std::string, std::string>& contexts = snapshot.contexts;
     
     std::string cumulative_text;
     const uint64_t comment_text_size = other_comments.size() * _format_config.total_char_limit;
@@ -161,66 +251,177 @@ std::string Tracker::construct_comments(const std::string& thread_id) {
     cumulative_text.reserve(comment_text_size + context_text_size);
 
     for(const auto& itr : other_comments) {
+        //Text changes always move the epoch, so only the author's expertise & the templates can go stale underneath it
+        Target target = _cfg_handler->target_map_find(itr.author);
+        const std::string expertise = target.is_empty() ? std::string() : target.data->expertise;
+        const std::string fragment_key = fmt::format("{}:{}:{}:{}", itr.comment_id, itr.epoch_time, _format_version, expertise);
+
+        if(const auto cached = _fragment_cache.get(fragment_key)) {
+            cumulative_text += *cached;
+            cumulative_text += "\n\n";
+            continue;
+        }
+
         const auto context_itr = contexts.find(itr.comment_id);
         const std::string comment_url = fmt::format("/r/{}/comments/{}/-/{}/", target_subreddit, itr.thread_id, itr.comment_id);
         
+        std::string fragment;
         if(context_itr != contexts.end()) {
-            cumulative_text += preformat_sticky_comment(itr.author, comment_url, itr.epoch_time, context_itr->second, itr.comment_text);
+            fragment = preformat_sticky_comment(itr.author, comment_url, itr.epoch_time, context_itr->second, itr.comment_text);
         }
         else {
-            cumulative_text += preformat_sticky_comment(itr.author, comment_url, itr.epoch_time, itr.comment_text);
+            fragment = preformat_sticky_comment(itr.author, comment_url, itr.epoch_time, itr.comment_text);
         }
+        cumulative_text += fragment;
+        _fragment_cache.put(fragment_key, std::move(fragment));
         cumulative_text += "\n\n";
     }
     
     return cumulative_text;
 }
 
-reddit::Comment Tracker::get_comment(const std::string& comment_id) {
-    const reddit::CommentListings commentlistings = _reddit_api->get_comment("t1_" + comment_id);
-
-    if(commentlistings.data.dist == 0) {
-        throw std::runtime_error("Invalid Comment ID was provided, resulting in 0 results.");
-    }
-
-    return commentlistings.children[0];
+void Tracker::approve_post(const dpp::interaction_create_t& event, const std::string& comment_id) {
+    const dpp::user supervisor = event.command.usr;
+    const Async_SQL::Error_Callback on_error = reply_on_error(event, "Approval");
+
+    //Built from the stored row rather than refetched, so the click costs only the sticky edit -
+    //whether the comment was deleted in the meantime is checked afterwards by the edit detection stage
+    _async_sql->post(
+        [comment_id, supervisor](sql_handler& sql) {
+            return sql.change_comment_status(comment_id, 1, supervisor.username, supervisor.id);
+        },
+        [this, comment_id, supervisor, on_error](const sql_handler::Status_Change& change) {
+            //The sticky edit waits on Reddit, so it runs on the Reddit executor & the SQL worker moves on
+            _reddit_tasks->post([this, comment = stored_comment(comment_id, change), supervisor]() {
+                //Read here rather than on the SQL worker - the executor runs one task at a time, so this sees
+                //the sticky & body any earlier approval on the thread published
+                const std::shared_ptr<const sql_handler::Thread_Snapshot> snapshot = _sql->get_thread_snapshot(comment.link_id.substr(3,9));
+                const std::string sticky_id = publish_approval(comment, *snapshot, Rate_Limiter::Priority::INTERACTIVE);
+                log_post_action(supervisor.username, comment, true, sticky_id);
+
+                //A full queue only delays the check until the comment's regular turn
+                _deletion_checks.try_push(comment.id);
+            }, on_error);
+        },
+        on_error
+    );
 }
-void Tracker::approve_post(const std::string& comment_id, const std::string& supervisor_username, int64_t supervisor_id) {
-    const reddit::Comment comment = get_comment(comment_id);
+void Tracker::approve_automatic(const Approval_Job& job) {
+    const reddit::Comment& comment = job.comment;
 
+    //Ingest fetched this comment moments ago, so it needs no second look
     if(comment.author == "[deleted]") {
         log_post_action("Invalid Post - Deleted", comment, false, "");
+        _sql->delete_pending_approval(comment.id);
         return;
     }
 
-    _sql->change_comment_status(comment.id, 1, supervisor_username, supervisor_id);
+    //Automatic approvals only queue the thread - a burst of replies from one dev merges into a single rebuild & edit
     const std::string trimmed_link_id = comment.link_id.substr(3,9);
-    const std::string sticky_comment = construct_comments(trimmed_link_id) + _format_config.footer;
-    const std::string sticky_id = _sql->get_sticky_id(trimmed_link_id);
+    _async_sql->post(
+        [comment, trimmed_link_id](sql_handler& sql) {
+            sql.change_comment_status(comment.id, 1, "Automatic", 0);
+            sql.enqueue_update(trimmed_link_id);
+            sql.delete_pending_approval(comment.id);
+            return sql.get_sticky_id(trimmed_link_id);
+        },
+        [this, comment](const std::string& sticky_id) {
+            log_post_action("Automatic", comment, true, sticky_id);
+        },
+        [this, job](std::exception_ptr error) {
+            try {
+                std::rethrow_exception(error);
+            }
+            catch(const std::exception& e) {
+                //The pending row is only deleted by a successful job, so it is still there for a retry or the next startup
+                Approval_Job retry = job;
+                ++retry.attempts;
+                if(retry.attempts < approval_max_attempts && _approval_queue.try_push(std::move(retry))) {
+                    spdlog::warn("Tracker: Automatic approval of {} failed, retrying - {}", job.comment.id, e.what());
+                }
+                else {
+                    spdlog::error("Tracker: Automatic approval of {} failed, left pending until restart - {}", job.comment.id, e.what());
+                }
+            }
+        }
+    );
+}
+std::string Tracker::publish_approval(const reddit::Comment& comment, const sql_handler::Thread_Snapshot& snapshot, Rate_Limiter::Priority priority) {
+    const std::string trimmed_link_id = comment.link_id.substr(3,9);
+    const std::string sticky_comment = construct_comments(snapshot) + _format_config.footer;
 
-    if(sticky_id.empty()) {
-        const reddit::Comment posted_comment = _reddit_api->post_comment(comment.link_id, sticky_comment);
-        _reddit_api->distinguish(posted_comment.name, true);
-        _reddit_api->lock(posted_comment.name);
-        _sql->insert_thread(trimmed_link_id, posted_comment.id);
-        log_post_action(supervisor_username, comment, true, posted_comment.id);
-    }
-    else {
-        _reddit_api->edit_comment("t1_" + sticky_id, sticky_comment);
-        log_post_action(supervisor_username, comment, true, sticky_id);
+    if(snapshot.sticky_id.empty()) {
+        const reddit::Comment posted_comment = _reddit_limiter->call(priority, [&]() {
+            return _reddit_api->post_comment(comment.link_id, sticky_comment);
+        });
+        _reddit_limiter->call(priority, [&]() { _reddit_api->distinguish(posted_comment.name, true); });
+        _reddit_limiter->call(priority, [&]() { _reddit_api->lock(posted_comment.name); });
+        _sql->insert_thread(trimmed_link_id, posted_comment.id, sticky_digest(sticky_comment));
+
+        return posted_comment.id;
     }
+
+    edit_sticky(trimmed_link_id, snapshot, sticky_comment, priority);
+    return snapshot.sticky_id;
+}
+reddit::Comment Tracker::stored_comment(const std::string& comment_id, const sql_handler::Status_Change& change) const {
+    //Only the fields log_post_action & publish_approval read
+    reddit::Comment res;
+    res.id = comment_id;
+    res.name = "t1_" + comment_id;
+    res.author = change.dev;
+    res.body = change.comment_text;
+    res.link_id = "t3_" + change.thread_id;
+    res.subreddit = _tracker_config.target_subreddit;
+    res.subreddit_name_prefixed = "r/" + _tracker_config.target_subreddit;
+    res.permalink = fmt::format("/r/{}/comments/{}/-/{}/", _tracker_config.target_subreddit, change.thread_id, comment_id);
+    res.created_utc = static_cast<float>(change.created_epoch);
+
+    return res;
 }
-void Tracker::deny_post(const std::string& comment_id, const std::string& supervisor_username, int64_t supervisor_id) {
-    const reddit::Comment comment = get_comment(comment_id);
-    _sql->change_comment_status(comment.id, 0, supervisor_username, supervisor_id);
+int64_t Tracker::sticky_digest(const std::string& body) {
+    return static_cast<int64_t>(Utility::fnv1a_hash(body));
+}
+bool Tracker::edit_sticky(const std::string& thread_id, const sql_handler::Thread_Snapshot& snapshot, const std::string& body, Rate_Limiter::Priority priority) {
+    //Rebuilds after a forced update or an edit past the truncation limit often come out byte-identical
+    const int64_t digest = sticky_digest(body);
+    if(snapshot.body_digest == digest) {
+        ++_sticky_edits_skipped;
+        return false;
+    }
+
+    _reddit_limiter->call(priority, [&]() { _reddit_api->edit_comment("t1_" + snapshot.sticky_id, body); });
+    _sql->set_thread_digest(thread_id, digest);
+    ++_sticky_edits_sent;
 
-    log_post_action(supervisor_username, comment, false, "");
+    return true;
+}
+void Tracker::deny_post(const dpp::interaction_create_t& event, const std::string& comment_id) {
+    const dpp::user supervisor = event.command.usr;
+
+    _async_sql->post(
+        [comment_id, supervisor](sql_handler& sql) {
+            return sql.change_comment_status(comment_id, 0, supervisor.username, supervisor.id);
+        },
+        [this, comment_id, supervisor](const sql_handler::Status_Change& change) {
+            log_post_action(supervisor.username, stored_comment(comment_id, change), false, "");
+        },
+        reply_on_error(event, "Denial")
+    );
 }
 void Tracker::log_post_action(const std::string& user, const reddit::Comment& comment, bool approved, const std::string& sticky_id) {
     const int32_t color = approved ? 0x00FF00 : 0xFF0000;
     const std::string action_string = approved ? "Approved by: " : "Denied by: ";
 
-    sql_handler::Dev_Ratio ratio = _sql->get_dev_ratio(comment.author);
+    sql_handler::Dev_Ratio ratio;
+    Target target = _cfg_handler->target_map_find(comment.author);
+    if(!target.is_empty()) {
+        ratio.dev_total = target.stats->dev_total;
+        ratio.dev_pinned = target.stats->dev_pinned;
+    }
+    else {
+        ratio = _sql->get_dev_ratio(comment.author);
+    }
 
     dpp::embed embed = dpp::embed()
         .set_title(comment.subreddit_name_prefixed)
@@ -267,25 +468,49 @@ void Tracker::log_post_action(const std::string& user, const reddit::Comment& co
         }
     });
 }
+Async_SQL::Error_Callback Tracker::reply_on_error(const dpp::interaction_create_t& event, const std::string& action) {
+    return [event, action](std::exception_ptr error) {
+        try {
+            std::rethrow_exception(error);
+        }
+        catch(const std::exception& e) {
+            spdlog::error("Tracker: {} failed - {}", action, e.what());
+            event.reply(dpp::ir_channel_message_with_source, fmt::format("{} failed: {}", action, e.what()));
+        }
+    };
+}
 void Tracker::switch_comment_status(const dpp::interaction_create_t& event, const std::string& comment_id) {
-    if(!_sql->check_comment_existence(comment_id)) {
-        throw std::runtime_error("Provided Comment ID does not exist in SQL Table.");
-    }
+    const dpp::user invoker = event.command.usr;
+    const Async_SQL::Error_Callback on_error = reply_on_error(event, "Status change");
 
-    const bool changed_status = !_sql->get_comment_status(comment_id);
+    _async_sql->post(
+        [comment_id, invoker](sql_handler& sql) {
+            if(!sql.check_comment_existence(comment_id)) {
+                throw std::runtime_error("Provided Comment ID does not exist in SQL Table.");
+            }
 
-    const dpp::user invoker = event.command.usr;
-    const std::string thread_id = _sql->change_comment_status(comment_id, static_cast<int>(changed_status), invoker.username, invoker.id);
-    update_thread_id(thread_id, true);
+            const bool changed_status = !sql.get_comment_status(comment_id);
+            const std::string thread_id = sql.change_comment_status(comment_id, static_cast<int>(changed_status), invoker.username, invoker.id).thread_id;
 
-    const std::string status_string = changed_status ? "Changed to Approved by: " : "Changed to Denied by: ";
+            return std::make_pair(changed_status, thread_id);
+        },
+        [this, event, invoker, on_error](const std::pair<bool, std::string>& res) {
+            //Rebuilding the sticky waits on Reddit, so it runs on the Reddit executor & the SQL worker moves on
+            _reddit_tasks->post([this, event, invoker, res]() {
+                update_thread_id(res.second, true);
 
-    dpp::embed embed = dpp::embed()
-        .set_title("Comment Status Changed")
-        .set_color(0xD133FF)
-        .set_footer(status_string + invoker.username, "");
+                const std::string status_string = res.first ? "Changed to Approved by: " : "Changed to Denied by: ";
 
-    event.reply(dpp::message(event.command.channel_id, embed));
+                dpp::embed embed = dpp::embed()
+                    .set_title("Comment Status Changed")
+                    .set_color(0xD133FF)
+                    .set_footer(status_string + invoker.username, "");
+
+                event.reply(dpp::message(event.command.channel_id, embed));
+            }, on_error);
+        },
+        on_error
+    );
 }
 
 void Tracker::send_for_approval(const reddit::Comment& comment) {
@@ -348,8 +573,12 @@ void Tracker::print_target_list(int64_t channel_id) {
     int suspended_count = 0;
 
     int minimum_spacing_req = 0;
-    const std::vector<Target::Data> targets = _cfg_handler->get_targets_vector_data();
-    for(const auto& itr : targets) {
+    const std::shared_ptr<const Target_Registry::Table> targets = _cfg_handler->target_map_snapshot();
+    for(const auto& target : targets->targets) {
+        if(target.data == nullptr) {
+            continue;
+        }
+        const Target::Data& itr = *target.data;
         if(itr.status == Target::Status::SUSPENDED) {
             ++suspended_count;
         }
@@ -358,10 +587,11 @@ void Tracker::print_target_list(int64_t channel_id) {
 
     std::string list_msg;
     list_msg.reserve(discord_msg_max + 6);
-    for(const auto& itr : targets) {
-        if(itr.status == Target::Status::SUSPENDED) {
+    for(const auto& target : targets->targets) {
+        if(target.data == nullptr || target.data->status == Target::Status::SUSPENDED) {
             continue;
         }
+        const Target::Data& itr = *target.data;
 
         const std::string status_symbol = Tracker::status_emote(itr.status);
 
@@ -377,7 +607,7 @@ void Tracker::print_target_list(int64_t channel_id) {
     int reserve_count = (list_msg.size() + discord_msg_max - 1) / discord_msg_max;
     message_batches.reserve(reserve_count + 1);
 
-    const std::string counter_message = fmt::format("> **{}** Users Registered On Tracker", targets.size()-suspended_count);
+    const std::string counter_message = fmt::format("> **{}** Users Registered On Tracker", targets->tracked-suspended_count);
     message_batches.emplace_back(dpp::message(channel_id, counter_message));
 
     if(list_msg.size() <= discord_msg_max) {
@@ -409,140 +639,420 @@ void Tracker::print_target_list(int64_t channel_id) {
 }
 
 void Tracker::tracker_thread_initiate() {
+    std::lock_guard<std::mutex> lock(_stop_mtx);
+    if(_stages_stopped) {
+        return;
+    }
     _tracker_on_flag = true;
 
-    std::thread([&]() {
+    //Ingest - new comments are stored & handed to the approval stage, never waiting behind edit or sticky work
+    _stage_threads.emplace_back([this]() {
+        for(Approval_Job& job : _recovered_approvals) {
+            if(!_approval_queue.push(std::move(job))) {
+                break;
+            }
+        }
+        _recovered_approvals.clear();
+
+        while(_tracker_on_flag) {
+            try {
+                tracker_iterate();
+            }
+            catch(const std::exception& e) {
+                spdlog::error("Tracker: Ingest pass failed - {}", e.what());
+            }
+            if(!wait_while_running(std::chrono::seconds(_tracker_config.tracker_interval))) {
+                break;
+            }
+            spdlog::debug("Tracker: Ingest pass complete");
+
+            const Connection_Pool::Stats pool_stats = _sql->get_pool_stats();
+            spdlog::debug("SQL Pool: {}/{} idle, {} checkouts ({} waited), avg wait {}us, max wait {}us, {} reconnects",
+                pool_stats.idle, pool_stats.pool_size, pool_stats.checkouts, pool_stats.contended_checkouts,
+                pool_stats.checkouts ? pool_stats.total_wait_us / static_cast<int64_t>(pool_stats.checkouts) : 0,
+                pool_stats.max_wait_us, pool_stats.reconnects);
+            spdlog::debug("Tracker: {} approvals & {} sticky threads queued", _approval_queue.size(), _update_coalescer->size());
+            spdlog::debug("Tracker: {} sticky edits sent, {} skipped as unchanged", _sticky_edits_sent.load(), _sticky_edits_skipped.load());
+        }
+    });
+
+    //Approval - posts to the queue channel at Discord's pace without holding up ingest
+    _stage_threads.emplace_back([this]() {
+        while(_tracker_on_flag) {
+            const std::optional<Approval_Job> job = _approval_queue.pop_for(std::chrono::seconds(_tracker_config.tracker_interval));
+            if(!job) {
+                continue;
+            }
+
+            try {
+                dispatch_approval(*job);
+            }
+            catch(const std::exception& e) {
+                spdlog::error("Tracker: Approval dispatch for {} failed - {}", job->comment.id, e.what());
+            }
+        }
+    });
+
+    //Edit detection - rescans the update window on its own cadence & queues touched threads for publishing
+    _stage_threads.emplace_back([this]() {
         while(_tracker_on_flag) {
-            tracker_iterate();
-            update_finder_iterate();
-            update_iterate();
-            std::this_thread::sleep_for(std::chrono::seconds(_tracker_config.tracker_interval));
-            std::cout << "Tracker Iterated" << std::endl;
+            try {
+                update_finder_iterate();
+                archive_iterate();
+            }
+            catch(const std::exception& e) {
+                spdlog::error("Tracker: Edit detection pass failed - {}", e.what());
+            }
+            if(!wait_while_running(std::chrono::seconds(_tracker_config.edit_check_interval))) {
+                break;
+            }
         }
-    }).detach();
+    });
+
+    //Sticky publish - fed by the update queue NOTIFY through the coalescer, with the tracker interval as a polling fallback
+    _update_listener = _sql->listen_for_updates([this](const std::string& thread_id) {
+        wake_sticky_updater(thread_id);
+    });
+    _stage_threads.emplace_back([this]() {
+        while(_tracker_on_flag) {
+            const std::vector<std::string> ready = _update_coalescer->wait_ready(std::chrono::seconds(_tracker_config.tracker_interval));
+            if(!_tracker_on_flag) {
+                break;
+            }
+
+            //A quiet interval only needs a poll when notifications can't be trusted
+            const bool sweep = _publish_resync.exchange(false) || (ready.empty() && !_update_listener->is_listening());
+            if(ready.empty() && !sweep) {
+                continue;
+            }
+
+            try {
+                if(sweep) {
+                    update_iterate();
+                }
+                else {
+                    publish_threads(std::unordered_set<std::string>(ready.begin(), ready.end()));
+                }
+            }
+            catch(const std::exception& e) {
+                spdlog::error("Tracker: Sticky update pass failed - {}", e.what());
+            }
+        }
+    });
+}
+bool Tracker::wait_while_running(std::chrono::seconds duration) {
+    std::unique_lock<std::mutex> lock(_stop_mtx);
+    return !_stop_cv.wait_for(lock, duration, [this]() { return !_tracker_on_flag; });
+}
+void Tracker::stop_stages() {
+    {
+        std::lock_guard<std::mutex> lock(_stop_mtx);
+        _stages_stopped = true;
+        _tracker_on_flag = false;
+    }
+    _stop_cv.notify_all();
+    //Wakes the stages blocked on a queue - a full approval queue included
+    _approval_queue.close();
+    _deletion_checks.close();
+    _update_coalescer->close();
+
+    for(auto& stage : _stage_threads) {
+        if(stage.joinable()) {
+            stage.join();
+        }
+    }
+    _stage_threads.clear();
+
+    //The NOTIFY callback reaches into the coalescer, so the listener's thread is joined here rather than left to member order
+    _update_listener.reset();
+}
+void Tracker::archive_iterate() {
+    const auto now = std::chrono::steady_clock::now();
+    if(_tracker_config.archive_interval <= 0 || now - _last_archive_run < std::chrono::hours(_tracker_config.archive_interval)) {
+        return;
+    }
+    _last_archive_run = now;
+
+    //Threads that fell out of the update window leave the hot tables - runs off the tracker thread as it can move a lot of rows
+    const int days = _tracker_config.update_day_limit;
+    _async_sql->post([days](sql_handler& sql) {
+        return sql.archive_cold_threads(days);
+    }, [](const sql_handler::Archive_Result& res) {
+        spdlog::info("Tracker: Archived {} comments & {} contexts, dropped {} orphaned contexts",
+            res.comments, res.contexts, res.orphaned_contexts);
+    });
+}
+void Tracker::wake_sticky_updater(const std::string& thread_id) {
+    //Called from the listener thread, so it must never block - the thread is still in the SQL queue if this overflows
+    if(thread_id.empty() || !_update_coalescer->touch(thread_id)) {
+        _publish_resync = true;
+    }
 }
 void Tracker::tracker_iterate() {
-    const reddit::Listing input = reddit::Listing().limit(_tracker_config.tracker_iterate_amount);
-    const reddit::CommentListings comments = _reddit_api->subreddit("friends").get_comments(input);
+    const std::vector<reddit::Comment> fresh_comments = fetch_new_friend_comments();
+    if(fresh_comments.empty()) {
+        return;
+    }
 
-    const std::string lowercase_target_subreddit = Utility::get_lowercase(_tracker_config.target_subreddit);
     const float minimum_epoch = _tracker_config.minimum_epoch;
 
-    //Process Contexts
-    std::vector<std::string> context_ids;
-    context_ids.reserve(comments.children.size());
+    //Pre-filter - only comments that will actually be stored need their parent fetched
+    struct Candidate {
+        const reddit::Comment* comment;
+        Target target;
+    };
+    std::vector<Candidate> candidates;
+    candidates.reserve(fresh_comments.size());
 
-    for(const auto& itr : comments.children) {
-        if(itr.parent_id.substr(0,2) == "t1" && 
-            Utility::get_lowercase(itr.subreddit) == lowercase_target_subreddit) 
-        {
-            context_ids.emplace_back(itr.parent_id);
-        }        
+    //Oldest first, so approvals queue up in posting order
+    for(auto itr = fresh_comments.rbegin(); itr != fresh_comments.rend(); ++itr) {
+        if(itr->created_utc < minimum_epoch || !Utility::iequals(itr->subreddit, _tracker_config.target_subreddit)) {
+            continue;
+        }
+
+        Target target = _cfg_handler->target_map_find(itr->author);
+        if(target.is_empty() || _sql->check_comment_existence(itr->id)) {
+            continue;
+        }
+        candidates.push_back({ &*itr, target });
     }
-    reddit::CommentListings contexts = _reddit_api->get_comments(context_ids);
 
-    auto process_comment = [&](const reddit::Comment& comment) {
-        const bool subcheck = Utility::get_lowercase(comment.subreddit) == lowercase_target_subreddit;
+    //Parent ID - Parent Body, filled from the context cache first & Reddit for the rest
+    std::unordered_map<std::string, std::string> contexts;
+    std::vector<std::string> missing_contexts;
+    contexts.reserve(candidates.size());
 
-        if(comment.created_utc < minimum_epoch || !subcheck) {
-            return;
+    for(const auto& candidate : candidates) {
+        const std::string& parent_id = candidate.comment->parent_id;
+        if(parent_id.substr(0,2) != "t1") {
+            continue;
         }
 
-        Target target = _cfg_handler->target_map_find(comment.author);
-        if(target.is_empty() || _sql->check_comment_existence(comment.id)) {
-            return;
+        const std::string trimmed_parent_id = parent_id.substr(3,9);
+        if(contexts.count(trimmed_parent_id)) {
+            continue;
+        }
+        if(const auto cached = _context_cache.get(trimmed_parent_id)) {
+            contexts.emplace(trimmed_parent_id, *cached);
         }
+        else {
+            //Placeholder keeps siblings replying to the same parent from requesting it twice
+            contexts.emplace(trimmed_parent_id, std::string());
+            missing_contexts.emplace_back(trimmed_parent_id);
+        }
+    }
+    //Parents Reddit no longer returns keep their empty placeholder & are stored without context
+    const Info_Fetcher::Result parents = _info_fetcher->fetch(missing_contexts, Rate_Limiter::Priority::INGEST);
+    for(const auto& [parent_id, parent] : parents.comments) {
+        contexts[parent_id] = parent.body;
+        _context_cache.put(parent_id, parent.body);
+    }
 
+    for(const auto& candidate : candidates) {
+        const reddit::Comment& comment = *candidate.comment;
         const std::string trimmed_link_id = comment.link_id.substr(3,8);
         const float timestamp = comment.edited ? comment.edited : comment.created_utc;
+        const Target::Status status = candidate.target.data->status;
+        const bool needs_approval = status == Target::Status::ACTIVE || status == Target::Status::AUTOMATIC;
 
         _sql->begin_transaction();
-        _sql->insert_comment(comment.id, trimmed_link_id, comment.author,
-            0, "", -1, timestamp, comment.body);
-
-        if(comment.parent_id.substr(0,2) == "t1") {
-            for(const auto& itr : contexts.children) {
-                if(itr.id == comment.parent_id.substr(3,9)) {
-                    _sql->insert_context(itr.id, trimmed_link_id, comment.id, true, itr.body);
-                    break;
+        try {
+            _sql->insert_comment(comment.id, trimmed_link_id, comment.author,
+                0, "", -1, timestamp, comment.created_utc, comment.body);
+
+            if(comment.parent_id.substr(0,2) == "t1") {
+                const auto context = contexts.find(comment.parent_id.substr(3,9));
+                if(context != contexts.end() && !context->second.empty()) {
+                    _sql->insert_context(context->first, trimmed_link_id, comment.id, true, context->second);
                 }
             }
+            //Committed with the comment - from here on the existence check skips it, so this row is what survives a restart
+            if(needs_approval) {
+                _sql->insert_pending_approval(comment.id, static_cast<int>(status));
+            }
+            _sql->commit_transaction();
+        }
+        catch(...) {
+            _sql->rollback_transaction();
+            throw;
         }
-        _sql->commit_transaction();
 
-        if(target.data->status == Target::Status::ACTIVE) {
-            send_for_approval(comment);
-            std::this_thread::sleep_for(std::chrono::seconds(2));
-        }	
-        else if(target.data->status == Target::Status::AUTOMATIC) {
-            approve_post(comment.id, "Automatic", 0);
+        //Blocks once the approval stage falls a full queue behind
+        if(needs_approval) {
+            _approval_queue.push({ comment, status });
         }
-    };
+    }
 
-    for(const auto& itr : comments.children) {
-        process_comment(itr);
+    //Only advanced once the whole batch is stored - a failed pass is fetched again & deduplicated by the existence check
+    _friends_feed_mark = fresh_comments.front().name;
+    _sql->set_tracker_state(friends_feed_mark_key, _friends_feed_mark);
+}
+std::vector<reddit::Comment> Tracker::fetch_new_friend_comments() {
+    //Base36 IDs grow with creation time, so the mark still works as a cutoff if its own comment is deleted
+    uint64_t mark = 0;
+    const bool has_mark = _friends_feed_mark.size() > 3 && Comment_Index::pack_id(_friends_feed_mark.substr(3), mark);
+
+    std::vector<reddit::Comment> res;
+    std::string after;
+    bool reached_mark = false;
+
+    //Without a mark there is nothing to catch up to - the newest page starts the cursor
+    const int max_pages = has_mark ? friends_feed_max_pages : 1;
+    for(int page = 0; page < max_pages && !reached_mark; ++page) {
+        reddit::Listing input = reddit::Listing().limit(_tracker_config.tracker_iterate_amount);
+        if(!after.empty()) {
+            input.after(after);
+        }
+        const reddit::CommentListings listing = _reddit_limiter->call(Rate_Limiter::Priority::INGEST, [&]() {
+            return _reddit_api->subreddit("friends").get_comments(input);
+        });
+
+        for(const auto& comment : listing.children) {
+            uint64_t packed = 0;
+            if(has_mark && Comment_Index::pack_id(comment.id, packed) && packed <= mark) {
+                reached_mark = true;
+                break;
+            }
+            res.push_back(comment);
+        }
+
+        if(listing.children.empty() || listing.data.after.empty()) {
+            break;
+        }
+        after = listing.data.after;
     }
+
+    if(has_mark && !reached_mark && !res.empty()) {
+        spdlog::warn("Tracker: Friends feed ran out after {} comments without reaching {} - older comments in the gap were missed",
+            res.size(), _friends_feed_mark);
+    }
+
+    return res;
 }
 void Tracker::update_finder_iterate() {
-    std::vector<std::string> entry_ids = _sql->get_comment_ids_by_date(_tracker_config.update_day_limit);
+    const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 
-    if(entry_ids.empty()) {
-        return;
-    }
+    //Drained before the walk, so every approval queued here is already committed & visible to it
+    const std::vector<std::string> expedited_ids = _deletion_checks.drain();
 
-    for(auto& itr : entry_ids) {
-        itr.reserve(3);
-        itr.insert(0, "t1_");
+    //The SQL walk is cheap next to Reddit - it keeps the schedule in step with approvals, deletions & the day window
+    //Each page goes straight into the schedule, so the walk only ever holds one page on top of it
+    _edit_scheduler.begin_sync();
+    _sql->for_each_comment_epoch_page(_tracker_config.update_day_limit, reddit_info_batch_size, [&](const sql_handler::Comment_Epoch_Page& page) {
+        _edit_scheduler.sync_page(page, now);
+    });
+    _edit_scheduler.end_sync();
+
+    //Moderator approvals go ahead of the schedule - they were never refetched, so a comment deleted before the click is caught here
+    std::vector<std::string> due_ids;
+    std::unordered_set<std::string> seen_ids;
+    for(const std::string& comment_id : expedited_ids) {
+        if(_edit_scheduler.stored_epoch(comment_id) && seen_ids.insert(comment_id).second) {
+            due_ids.push_back(comment_id);
+        }
     }
-    const reddit::CommentListings comments = _reddit_api->get_comments(entry_ids);
-    const std::map<std::string, int64_t> entry_timestamps = _sql->get_comment_id_epoch_pair_by_date(_tracker_config.update_day_limit);
+    for(std::string& comment_id : _edit_scheduler.take_due(now, reddit_info_batch_size)) {
+        if(seen_ids.insert(comment_id).second) {
+            due_ids.push_back(std::move(comment_id));
+        }
+    }
+    const Info_Fetcher::Result fetched = _info_fetcher->fetch(due_ids, Rate_Limiter::Priority::BACKGROUND);
 
-    for(const auto& itr : comments.children) {
+    sql_handler::Write_Batch batch;
+    std::unordered_set<std::string> edited_ids;
+    std::unordered_set<std::string> queued_threads;
+
+    for(const auto& [comment_id, itr] : fetched.comments) {
         if(itr.author == "[deleted]") {
-            _sql->delete_comment(itr.id);
+            batch.delete_comment(comment_id);
         }
         else {
-            if(itr.edited == 0.0F || itr.edited == entry_timestamps.at(itr.id)) {
+            if(itr.edited == 0.0F || itr.edited == _edit_scheduler.stored_epoch(comment_id).value_or(0)) {
                 continue;
             }
 
-            _sql->update_comment(itr.id, itr.body, itr.edited);
+            batch.update_comment(comment_id, itr.body, itr.edited);
+            edited_ids.insert(comment_id);
         }
         const std::string trimmed_link_id = itr.link_id.substr(3,9);
-        _sql->enqueue_update(trimmed_link_id);
+        if(queued_threads.insert(trimmed_link_id).second) {
+            batch.enqueue_update(trimmed_link_id);
+        }
     }
-}
-void Tracker::update_iterate() {
-    const std::unordered_set<std::string> update_queue = _sql->get_update_queue();
 
-    for (const auto& thread_id_itr : update_queue) {
-        const std::vector<sql_handler::Comment_Response> stored_comments = _sql->get_comments_in_thread(thread_id_itr);
-        std::string cumulative_text = construct_comments(thread_id_itr);
-        const std::string sticky_id = _sql->get_sticky_id(thread_id_itr);
+    if(!batch.empty()) {
+        _sql->execute_batch(batch);
+    }
 
-        if(!cumulative_text.empty()) {
-            cumulative_text += _format_config.footer;
-            if(!sticky_id.empty()) {
-                _reddit_api->edit_comment("t1_" + sticky_id, cumulative_text);
-            }
-            else {
-                const std::string link_id = stored_comments.front().thread_id;
-                reddit::Comment posted_comment = _reddit_api->post_comment("t3_" + link_id, cumulative_text);
-                _reddit_api->distinguish(posted_comment.name, true);
-                _reddit_api->lock(posted_comment.name);
-                _sql->insert_thread(thread_id_itr, posted_comment.id);
-            }
+    for(const std::string& comment_id : due_ids) {
+        _edit_scheduler.record_check(comment_id, now, edited_ids.count(comment_id) != 0);
+    }
+    if(!fetched.missing.empty()) {
+        spdlog::debug("Tracker: Reddit returned nothing for {} tracked comments", fetched.missing.size());
+    }
+
+    spdlog::debug("Tracker: Checked {} of {} tracked comments for edits", due_ids.size(), _edit_scheduler.size());
+}
+void Tracker::dispatch_approval(const Approval_Job& job) {
+    if(job.status == Target::Status::AUTOMATIC) {
+        //Cleared by the approval's own SQL job once it has been written
+        approve_automatic(job);
+        return;
+    }
+
+    if(job.status == Target::Status::ACTIVE) {
+        send_for_approval(job.comment);
+    }
+    //The queue message is with DPP now - the moderator's click is what decides the comment from here
+    _sql->delete_pending_approval(job.comment.id);
+}
+void Tracker::update_iterate() {
+    publish_threads(_sql->get_update_queue());
+}
+void Tracker::publish_threads(const std::unordered_set<std::string>& thread_ids) {
+    for(const auto& thread_id : thread_ids) {
+        if(!_tracker_on_flag) {
+            return;
+        }
+        publish_thread(thread_id);
+    }
+}
+void Tracker::publish_thread(const std::string& thread_id) {
+    //A sweep covers anything still waiting out its debounce; requests arriving from here on schedule a fresh rebuild
+    _update_coalescer->erase(thread_id);
+
+    const std::shared_ptr<const sql_handler::Thread_Snapshot> snapshot = _sql->get_thread_snapshot(thread_id);
+    std::string cumulative_text = construct_comments(*snapshot);
+    const std::string& sticky_id = snapshot->sticky_id;
+
+    if(!cumulative_text.empty()) {
+        cumulative_text += _format_config.footer;
+        if(!sticky_id.empty()) {
+            edit_sticky(thread_id, *snapshot, cumulative_text, Rate_Limiter::Priority::BACKGROUND);
         }
         else {
-            _sql->begin_transaction();
-            _sql->delete_thread(thread_id_itr);
-            _reddit_api->edit().del("t1_" + sticky_id);
+            const reddit::Comment posted_comment = _reddit_limiter->call(Rate_Limiter::Priority::BACKGROUND, [&]() {
+                return _reddit_api->post_comment("t3_" + thread_id, cumulative_text);
+            });
+            _reddit_limiter->call(Rate_Limiter::Priority::BACKGROUND, [&]() { _reddit_api->distinguish(posted_comment.name, true); });
+            _reddit_limiter->call(Rate_Limiter::Priority::BACKGROUND, [&]() { _reddit_api->lock(posted_comment.name); });
+            _sql->insert_thread(thread_id, posted_comment.id, sticky_digest(cumulative_text));
+        }
+    }
+    else {
+        _sql->begin_transaction();
+        try {
+            _sql->delete_thread(thread_id);
+            _reddit_limiter->call(Rate_Limiter::Priority::BACKGROUND, [&]() { _reddit_api->edit().del("t1_" + sticky_id); });
             _sql->commit_transaction();
         }
-        
-        _sql->dequeue_update(thread_id_itr);
-        std::this_thread::sleep_for(std::chrono::seconds(3));
+        catch(...) {
+            _sql->rollback_transaction();
+            throw;
+        }
     }
+
+    _sql->dequeue_update(thread_id);
 }
 
 dpp::embed Tracker::pre_user_embed(const reddit::UserAbout& user, const reddit::CommentListings& comments, int comment_cap) {
@@ -606,9 +1116,13 @@ void Tracker::add_target_menu(const dpp::interaction_create_t& event, const std:
                 .add_component(cancel_button);
 
             reddit::User targeted_user = _reddit_api->user(target);
-            reddit::UserAbout userinfo = targeted_user.get_about();
+            reddit::UserAbout userinfo = _reddit_limiter->call(Rate_Limiter::Priority::INTERACTIVE, [&]() {
+                return targeted_user.get_about();
+            });
             reddit::Listing usercomment_input = reddit::Listing().limit(3);
-            reddit::CommentListings usercomments = targeted_user.get_comments(usercomment_input);  
+            reddit::CommentListings usercomments = _reddit_limiter->call(Rate_Limiter::Priority::INTERACTIVE, [&]() {
+                return targeted_user.get_comments(usercomment_input);
+            });
 
             const dpp::embed user_card_embed = pre_user_embed(userinfo, usercomments, 150);
             const dpp::message res =  dpp::message(event.command.channel_id, user_card_embed)
@@ -703,8 +1217,10 @@ void Tracker::edit_target_menu(const dpp::interaction_create_t& event, const std
             event.get_original_response([this, target](const dpp::confirmation_callback_t& msg_callback) {
                 const dpp::message& finalized_msg = std::get<dpp::message>(msg_callback.value);
                 
-                target.data->managing_msg_id = finalized_msg.id;
-                target.data->msg_channel = finalized_msg.channel_id;
+                _cfg_handler->target_map_update(target.data->username, [&](Target::Data& data) {
+                    data.managing_msg_id = finalized_msg.id;
+                    data.msg_channel = finalized_msg.channel_id;
+                });
                 _sql->insert_devedit_session(target.data->username, finalized_msg.id, finalized_msg.channel_id);
             });
         }
@@ -714,15 +1230,15 @@ void Tracker::close_target_menu(const std::string& target) {
     _sql->delete_devedit_session(target);
 }
 void Tracker::change_target_status(const dpp::interaction_create_t& event, const std::string& target_name, Target::Status status) {
-    Target target = _cfg_handler->target_map_find(target_name);
-
-    const Target::Status old_status = target.data->status;
+    const Target::Status old_status = _cfg_handler->target_map_find(target_name).data->status;
 
     if(old_status == Target::Status::SUSPENDED) {
         add_target_to_tracker(event, target_name);
     }
 
-    target.data->status = status;
+    const Target target = _cfg_handler->target_map_update(target_name, [status](Target::Data& data) {
+        data.status = status;
+    });
 
     const dpp::embed embed = dpp::embed()
         .set_title("Status Changed")
@@ -744,8 +1260,9 @@ void Tracker::change_target_status(const dpp::interaction_create_t& event, const
     });
 }
 void Tracker::change_target_expertise(const dpp::interaction_create_t& event, const std::string& target_name, const std::string& expertise) {
-    Target target = _cfg_handler->target_map_find(target_name);
-    target.data->expertise = expertise;
+    const Target target = _cfg_handler->target_map_update(target_name, [&expertise](Target::Data& data) {
+        data.expertise = expertise;
+    });
 
     const dpp::embed embed = dpp::embed()
         .set_title("Expertise Changed")
@@ -766,17 +1283,23 @@ void Tracker::change_target_expertise(const dpp::interaction_create_t& event, co
     });
 }
 void Tracker::add_target_to_tracker(const dpp::interaction_create_t& event, const std::string& target_name) {
-    const reddit::FriendResponse resp = _reddit_api->user(target_name).add_friend();
+    const reddit::FriendResponse resp = _reddit_limiter->call(Rate_Limiter::Priority::INTERACTIVE, [&]() {
+        return _reddit_api->user(target_name).add_friend();
+    });
 
-    Target target;
-    target.data = std::make_shared<Target::Data>();
-    target.data->username = resp.name;
-    target.data->status = Target::Status::ACTIVE;
+    auto data = std::make_shared<Target::Data>();
+    data->username = resp.name;
+    data->status = Target::Status::ACTIVE;
 
-    _sql->upsert_dev(target.data->username, target.data->expertise, target.data->status,
+    const sql_handler::Dev_Ratio ratio = _sql->get_dev_ratio(data->username);
+    auto stats = std::make_shared<Target::Stats>();
+    stats->dev_total = ratio.dev_total;
+    stats->dev_pinned = ratio.dev_pinned;
+
+    _sql->upsert_dev(data->username, data->expertise, data->status,
         event.command.usr.username, event.command.usr.id);
 
-    _cfg_handler->target_map_emplace(target);
+    _cfg_handler->target_map_emplace(Target{ std::move(data), std::move(stats) });
 }
 bool Tracker::suspend_target(const dpp::interaction_create_t& event, const std::string& target_name) {
     Target target = _cfg_handler->target_map_find(target_name);
@@ -784,7 +1307,7 @@ bool Tracker::suspend_target(const dpp::interaction_create_t& event, const std::
         return false;
     }
 
-    _reddit_api->user(target_name).remove_friend();
+    _reddit_limiter->call(Rate_Limiter::Priority::INTERACTIVE, [&]() { _reddit_api->user(target_name).remove_friend(); });
 
     change_target_status(event, target_name, Target::Status::SUSPENDED);
     _cfg_handler->target_map_remove(target_name);
@@ -793,58 +1316,154 @@ bool Tracker::suspend_target(const dpp::interaction_create_t& event, const std::
 }
 
 int Tracker::update_thread(const std::string& thread_id, const std::map<std::string, int64_t>& timestamps, bool ignore_edit_checks) {
-    std::vector<std::string> entry_ids = _sql->get_comment_ids_by_thread_id(thread_id);
-    
-    for(auto& itr : entry_ids) {
-        itr.reserve(3);
-        itr.insert(0, "t1_");
-    }
-    const reddit::CommentListings info = _reddit_api->get_comments(entry_ids);
+    const std::vector<std::string> entry_ids = _sql->get_comment_ids_by_thread_id(thread_id);
+    //Busy threads can hold more comments than one info call returns
+    const Info_Fetcher::Result info = _info_fetcher->fetch(entry_ids, Rate_Limiter::Priority::BACKGROUND);
 
-    int update_count = 0;
+    sql_handler::Write_Batch batch;
 
-    if(info.data.dist != 0) {
-        for(const auto& comment : info.children) {
-            if(comment.author == "[deleted]") {
-                _sql->delete_comment(comment.id);
+    for(const auto& [comment_id, comment] : info.comments) {
+        if(comment.author == "[deleted]") {
+            batch.delete_comment(comment_id);
+        }
+        else {
+            if(ignore_edit_checks) {
+                const float timestamp = (comment.edited != 0.0F) ? comment.edited : comment.created_utc;
+                batch.update_comment(comment_id, comment.body, timestamp);
             }
             else {
-                if(ignore_edit_checks) {
-                    const float timestamp = (comment.edited != 0.0F) ? comment.edited : comment.created_utc;
-                    _sql->update_comment(comment.id, comment.body, timestamp);
+                if(comment.edited == 0.0F || comment.edited == timestamps.at(comment_id)){
+                    continue;
                 }
-                else {
-                    if(comment.edited == 0.0F || comment.edited == timestamps.at(comment.id)){
-                        continue;
-                    }
 
-                    _sql->update_comment(comment.id, comment.body, comment.edited);
-                }
+                batch.update_comment(comment_id, comment.body, comment.edited);
             }
-            ++update_count;
         }
     }
-    _sql->enqueue_update(thread_id);
+    batch.enqueue_update(thread_id);
+
+    const std::vector<sql_handler::Batch_Result> results = _sql->execute_batch(batch);
+    //UPDATE_COMMENT only touches a row whose stored epoch is older, so 0 rows means nothing was written
+    const int update_count = std::count_if(results.begin(), results.end(), [](const sql_handler::Batch_Result& result) {
+        return result.write == sql_handler::Batch_Write::UPDATE_COMMENT && result.success && result.affected_rows > 0;
+    });
 
     return update_count;
 }
 int Tracker::update_thread_id(const std::string& thread_id, bool ignore_edit_checks) {
+    //An archived thread would otherwise render as empty & lose its sticky
+    _sql->restore_archived_thread(thread_id);
+
     const std::map<std::string, int64_t> entry_timestamps = _sql->get_comment_id_epoch_pair_by_thread_id(thread_id);
     return update_thread(thread_id, entry_timestamps, ignore_edit_checks);
 }
-int Tracker::update_thread_id_by_days(const std::string& thread_id, int days, bool ignore_edit_checks) {
-    const std::map<std::string, int64_t> entry_timestamps = _sql->get_comment_id_epoch_pair_by_date(days);
-    return update_thread(thread_id, entry_timestamps, ignore_edit_checks);
+
+void Tracker::force_update(const dpp::interaction_create_t& event, int days) {
+    if(_force_update_running.exchange(true)) {
+        event.reply(dpp::message("A force update is already running.").set_flags(dpp::m_ephemeral));
+        return;
+    }
+    _force_update_cancel = false;
+    event.reply(dpp::message("Force update started.").set_flags(dpp::m_ephemeral));
+
+    const dpp::component cancel_button = dpp::component()
+        .set_label("Cancel")
+        .set_type(dpp::cot_button)
+        .set_style(dpp::cos_danger)
+        .set_id("cancel_force_update");
+    const dpp::component action_row = dpp::component()
+        .set_type(dpp::cot_action_row)
+        .add_component(cancel_button);
+    const dpp::message progress_msg = dpp::message(event.command.channel_id, fmt::format("Force updating posts <{} days - loading threads", days))
+        .add_component(action_row);
+
+    _bot->message_create(progress_msg, [this, days](const dpp::confirmation_callback_t& msg_callback) {
+        if(msg_callback.is_error()) {
+            _force_update_running = false;
+            throw std::runtime_error("Failed to create Force Update Message:\n" + msg_callback.get_error().message);
+        }
+
+        std::lock_guard<std::mutex> lock(_force_update_mtx);
+        _force_update_job = std::async(std::launch::async, [this, posted_msg = std::get<dpp::message>(msg_callback.value), days]() {
+            run_force_update(posted_msg, days);
+        });
+    });
 }
+void Tracker::cancel_force_update(const dpp::interaction_create_t& event) {
+    if(!_force_update_running) {
+        event.reply(dpp::message("No force update is running.").set_flags(dpp::m_ephemeral));
+        return;
+    }
 
-int Tracker::force_update(int days) {
-    int total_updated = 0;
+    _force_update_cancel = true;
+    event.reply(dpp::message("Cancelling - threads already being updated will finish first.").set_flags(dpp::m_ephemeral));
+}
+void Tracker::run_force_update(dpp::message progress_msg, int days) {
+    std::vector<std::string> thread_ids;
+    std::atomic<std::size_t> next_thread{ 0 };
+    std::atomic<int> threads_done{ 0 };
+    std::atomic<int> comments_updated{ 0 };
+    std::atomic<int> failures{ 0 };
+
+    const auto report = [&](const std::string& state, bool finished) {
+        progress_msg.set_content(fmt::format("Force updating posts <{} days - {}\n{}/{} threads, {} comments updated, {} failed",
+            days, state, threads_done.load(), thread_ids.size(), comments_updated.load(), failures.load()));
+        if(finished) {
+            progress_msg.components.clear();
+        }
 
-    const std::vector<std::string> thread_ids = _sql->get_thread_ids_by_date(days);
-    for(const auto& thread_id : thread_ids) {
-        total_updated += update_thread_id_by_days(thread_id, days, true);
+        _bot->message_edit(progress_msg, [](const dpp::confirmation_callback_t& msg_callback) {
+            if(msg_callback.is_error()) {
+                spdlog::warn("Tracker: Failed to edit Force Update Message - {}", msg_callback.get_error().message);
+            }
+        });
+    };
+
+    try {
+        _sql->for_each_thread_id_page(days, reddit_info_batch_size, [&](const std::vector<std::string>& page) {
+            thread_ids.insert(thread_ids.end(), page.begin(), page.end());
+        });
+    }
+    catch(const std::exception& e) {
+        spdlog::error("Tracker: Force update could not load threads - {}", e.what());
+        report("failed to load threads", true);
+        _force_update_running = false;
+        return;
+    }
+
+    //Every worker goes through the BACKGROUND lane, so the job spends spare Reddit budget without starving approvals or ingest
+    const std::size_t worker_count = std::min(force_update_workers, thread_ids.size());
+    std::vector<std::future<void>> workers;
+    workers.reserve(worker_count);
+    for(std::size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back(std::async(std::launch::async, [&]() {
+            for(std::size_t idx = next_thread++; idx < thread_ids.size() && !_force_update_cancel; idx = next_thread++) {
+                const std::string& thread_id = thread_ids[idx];
+                try {
+                    //An archived thread would otherwise render as empty & lose its sticky
+                    _sql->restore_archived_thread(thread_id);
+                    //Every stored comment is rewritten, so the thread's epochs are never needed
+                    comments_updated += update_thread(thread_id, {}, true);
+                }
+                catch(const std::exception& e) {
+                    ++failures;
+                    spdlog::error("Tracker: Force update of thread {} failed - {}", thread_id, e.what());
+                }
+                ++threads_done;
+            }
+        }));
+    }
+
+    for(auto& worker : workers) {
+        while(worker.wait_for(force_update_progress_interval) != std::future_status::ready) {
+            report(_force_update_cancel ? "cancelling" : "running", false);
+        }
     }
 
-    return total_updated;
+    const bool cancelled = _force_update_cancel;
+    spdlog::info("Tracker: Force update {} after {}/{} threads, {} comments updated",
+        cancelled ? "cancelled" : "finished", threads_done.load(), thread_ids.size(), comments_updated.load());
+    report(cancelled ? "cancelled" : "finished", true);
+    _force_update_running = false;
 }
 
@@ -1,11 +1,13 @@
 #include "trackerbot/trackercfg.h"
 
 #include "trackerbot/sql.h"
-#include "trackerbot/utility.h"
+#include "trackerbot/target_registry.h"
 
 #include <rapidjson/document.h>
 #include <rapidjson/filereadstream.h>
 
+#include <memory>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -38,9 +40,15 @@ void TrackerConfig::load_config() {
     rapidjson::Value& tracker_cfg = doc["Tracker_Config"];
     _tracker_config.target_subreddit = tracker_cfg["Target_Subreddit"].GetString();
     _tracker_config.tracker_interval = tracker_cfg["Tracker_Interval"].GetInt();
+    _tracker_config.edit_check_interval = tracker_cfg.HasMember("Edit_Check_Interval") ? tracker_cfg["Edit_Check_Interval"].GetInt() : _tracker_config.tracker_interval;
     _tracker_config.tracker_iterate_amount = tracker_cfg["Tracker_Iterate_Amount"].GetInt();
     _tracker_config.update_day_limit = tracker_cfg["Update_Day_Limit"].GetInt();
+    _tracker_config.sticky_debounce = tracker_cfg.HasMember("Sticky_Debounce_Seconds") ? tracker_cfg["Sticky_Debounce_Seconds"].GetInt() : 15;
+    _tracker_config.sticky_max_delay = tracker_cfg.HasMember("Sticky_Max_Delay_Seconds") ? tracker_cfg["Sticky_Max_Delay_Seconds"].GetInt() : 60;
+    _tracker_config.archive_interval = tracker_cfg.HasMember("Archive_Interval_Hours") ? tracker_cfg["Archive_Interval_Hours"].GetInt() : 24;
     _tracker_config.minimum_epoch =tracker_cfg["Minimum_Epoch"].GetFloat();
+    _tracker_config.reddit_requests_per_minute = tracker_cfg.HasMember("Reddit_Requests_Per_Minute") ? tracker_cfg["Reddit_Requests_Per_Minute"].GetDouble() : 60.0;
+    _tracker_config.reddit_burst = tracker_cfg.HasMember("Reddit_Burst") ? tracker_cfg["Reddit_Burst"].GetInt() : 10;
 
     rapidjson::Value& reddit_cfg = doc["Reddit_Config"];
     _reddit_config.client_id = reddit_cfg["Client_Id"].GetString();
@@ -61,6 +69,8 @@ void TrackerConfig::load_config() {
     rapidjson::Value& sql_cfg = doc["SQL_Config"];
     _sql_config.admin_credentials = sql_cfg["Admin_Credentials"].GetString();
     _sql_config.conn_string = sql_cfg["Connection_String"].GetString();
+    _sql_config.pool_size = sql_cfg.HasMember("Pool_Size") ? sql_cfg["Pool_Size"].GetInt() : 4;
+    _sql_config.async_workers = sql_cfg.HasMember("Async_Workers") ? sql_cfg["Async_Workers"].GetInt() : 1;
 
     rapidjson::Value& format_cfg = doc["Format_Config"];
     _format_config.total_char_limit = format_cfg["Main_Char_Limit"].GetInt();
@@ -101,24 +111,35 @@ TrackerConfig::Format_Config TrackerConfig::get_format_config() {
     return _format_config;
 }
 
-Target TrackerConfig::target_map_find(const std::string& username) {
-    const auto itr = _target_map.find(Utility::get_lowercase(username));
-    if(itr == _target_map.end()) {
-        return Target();
+Target TrackerConfig::target_map_find(std::string_view username) {
+    return _target_map.find(username);
+}
+void TrackerConfig::target_map_assign(const std::unordered_map<std::string, Target>& targets) {
+    std::vector<Target> res;
+    res.reserve(targets.size());
+    for(const auto& itr : targets) {
+        res.push_back(itr.second);
     }
 
-    return itr->second;
-}
-void TrackerConfig::target_map_reserve(int reserve_count) {
-    _target_map.reserve(reserve_count);
+    _target_map.assign(res);
 }
 void TrackerConfig::target_map_emplace(const Target& target) {
-    const std::string username = Utility::get_lowercase(target.data->username);
-    _target_map.emplace(username, target);
+    _target_map.emplace(target);
+}
+void TrackerConfig::target_map_remove(std::string_view username) {
+    _target_map.remove(username);
+}
+Target TrackerConfig::target_map_update(std::string_view username, const Target_Registry::Modifier& modify) {
+    return _target_map.update(username, modify);
 }
-void TrackerConfig::target_map_remove(const std::string& username) {
-    const auto itr = _target_map.find(Utility::get_lowercase(username));
-    _target_map.erase(itr);
+Username_Interner::Id TrackerConfig::target_map_id_of(std::string_view username) {
+    return _target_map.id_of(username);
+}
+void TrackerConfig::target_map_add_stats(Username_Interner::Id id, int total_delta, int pinned_delta) {
+    _target_map.add_stats(id, total_delta, pinned_delta);
+}
+std::shared_ptr<const Target_Registry::Table> TrackerConfig::target_map_snapshot() {
+    return _target_map.snapshot();
 }
 User TrackerConfig::user_map_find(int64_t user_id) {
     const auto itr = _user_map.find(user_id);
@@ -127,13 +148,4 @@ User TrackerConfig::user_map_find(int64_t user_id) {
     }
 
     return itr->second;
-}
-std::vector<Target::Data> TrackerConfig::get_targets_vector_data() {
-    std::vector<Target::Data> res;
-    res.reserve(_target_map.size());
-    for(const auto& itr : _target_map) {
-        res.emplace_back(*(itr.second.data));
-    }
-
-    return res;
 }
\ No newline at end of file
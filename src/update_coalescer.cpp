@@ -0,0 +1,90 @@
+#include "trackerbot/update_coalescer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+Update_Coalescer::Update_Coalescer(Clock::duration debounce, Clock::duration max_delay, std::size_t capacity)
+	: _debounce(debounce)
+	, _max_delay(std::max(max_delay, debounce))
+	, _capacity(std::max<std::size_t>(capacity, 1))
+{
+}
+
+bool Update_Coalescer::touch(const std::string& thread_id) {
+	const Clock::time_point now = Clock::now();
+	{
+		std::lock_guard<std::mutex> lock(_pending_mtx);
+		if(_closed) {
+			return false;
+		}
+
+		const auto itr = _pending.find(thread_id);
+		if(itr != _pending.end()) {
+			//Each request pushes the rebuild back, but never past the cap set by the first one
+			itr->second.due = std::min(now + _debounce, itr->second.first_touch + _max_delay);
+		}
+		else {
+			if(_pending.size() >= _capacity) {
+				return false;
+			}
+			_pending.emplace(thread_id, Pending{ now, now + _debounce });
+		}
+	}
+	_pending_cv.notify_all();
+
+	return true;
+}
+void Update_Coalescer::erase(const std::string& thread_id) {
+	std::lock_guard<std::mutex> lock(_pending_mtx);
+	_pending.erase(thread_id);
+}
+
+std::vector<std::string> Update_Coalescer::wait_ready(Clock::duration max_wait) {
+	const Clock::time_point deadline = Clock::now() + max_wait;
+
+	std::unique_lock<std::mutex> lock(_pending_mtx);
+	while(!_closed) {
+		const Clock::time_point now = Clock::now();
+
+		std::vector<std::string> res;
+		Clock::time_point next_due = deadline;
+		for(const auto& [thread_id, pending] : _pending) {
+			if(pending.due <= now) {
+				res.emplace_back(thread_id);
+			}
+			else {
+				next_due = std::min(next_due, pending.due);
+			}
+		}
+
+		if(!res.empty()) {
+			for(const auto& thread_id : res) {
+				_pending.erase(thread_id);
+			}
+			return res;
+		}
+		if(now >= deadline) {
+			break;
+		}
+
+		_pending_cv.wait_until(lock, next_due);
+	}
+
+	return {};
+}
+void Update_Coalescer::close() {
+	{
+		std::lock_guard<std::mutex> lock(_pending_mtx);
+		_closed = true;
+	}
+	_pending_cv.notify_all();
+}
+
+std::size_t Update_Coalescer::size() {
+	std::lock_guard<std::mutex> lock(_pending_mtx);
+	return _pending.size();
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "trackerbot/update_listener.h"
+
+#include <pqxx/pqxx>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace {
+	constexpr std::chrono::milliseconds initial_backoff{ 1000 };
+	constexpr std::chrono::milliseconds max_backoff{ 30000 };
+	//Upper bound on how long shutdown waits for the listen thread
+	constexpr long await_timeout_seconds = 1;
+
+	class Update_Receiver : public pqxx::notification_receiver {
+	public:
+		Update_Receiver(pqxx::connection& conn, const std::string& channel, const Update_Listener::Notify_Function& on_notify)
+			: pqxx::notification_receiver(conn, channel)
+			, _on_notify(on_notify)
+		{
+		}
+
+		void operator()(const std::string& payload, int /*backend_pid*/) override {
+			_on_notify(payload);
+		}
+
+	private:
+		const Update_Listener::Notify_Function& _on_notify;
+	};
+}
+
+Update_Listener::Update_Listener(std::string conn_string, std::string channel, Notify_Function on_notify)
+	: _connection_string(std::move(conn_string))
+	, _channel(std::move(channel))
+	, _on_notify(std::move(on_notify))
+	, _running(true)
+	, _listening(false)
+{
+	_listen_thread = std::thread(&Update_Listener::listen_loop, this);
+}
+Update_Listener::~Update_Listener() {
+	_running = false;
+	if(_listen_thread.joinable()) {
+		_listen_thread.join();
+	}
+}
+
+bool Update_Listener::is_listening() const {
+	return _listening;
+}
+
+void Update_Listener::listen_loop() {
+	std::chrono::milliseconds backoff = initial_backoff;
+
+	while(_running) {
+		try {
+			pqxx::connection conn{ _connection_string };
+			Update_Receiver receiver{ conn, _channel, _on_notify };
+			_listening = true;
+			backoff = initial_backoff;
+			spdlog::info("SQL: Listening for update notifications on {}", _channel);
+			//Anything queued while no one was listening is only picked up by a sweep
+			_on_notify("");
+
+			while(_running) {
+				conn.await_notification(await_timeout_seconds, 0);
+			}
+		}
+		catch(const std::exception& e) {
+			_listening = false;
+			spdlog::warn("SQL: Update listener dropped, retrying in {}ms - {}", backoff.count(), e.what());
+
+			const auto retry_at = std::chrono::steady_clock::now() + backoff;
+			while(_running && std::chrono::steady_clock::now() < retry_at) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			}
+			backoff = std::min(backoff * 2, max_backoff);
+		}
+	}
+
+	_listening = false;
+}
\ No newline at end of file
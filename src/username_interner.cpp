@@ -0,0 +1,67 @@
+#include "trackerbot/username_interner.h"
+
+#include "trackerbot/utility.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+std::size_t Case_Insensitive_Hash::operator()(std::string_view value) const {
+	return static_cast<std::size_t>(Utility::fnv1a_hash_folded(value));
+}
+bool Case_Insensitive_Equal::operator()(std::string_view lhs, std::string_view rhs) const {
+	return Utility::iequals(lhs, rhs);
+}
+
+Username_Interner::Username_Interner()
+	: _table(std::make_shared<const Table>())
+{
+}
+
+Username_Interner::Id Username_Interner::intern(std::string_view username) {
+	if(const Id existing = find(username); existing != invalid_id) {
+		return existing;
+	}
+
+	std::lock_guard<std::mutex> lock(_writer_mtx);
+	const std::shared_ptr<const Table> current = snapshot();
+	//Another writer may have interned it since the lock-free check
+	if(const auto itr = current->ids.find(username); itr != current->ids.end()) {
+		return itr->second;
+	}
+	if(current->names.size() >= invalid_id) {
+		throw std::runtime_error("Username interner is full.");
+	}
+
+	auto next = std::make_shared<Table>(*current);
+	const Id id = static_cast<Id>(next->names.size());
+	next->names.push_back(std::make_shared<const std::string>(username));
+	next->ids.emplace(*next->names.back(), id);
+
+	std::atomic_store_explicit(&_table, std::shared_ptr<const Table>(std::move(next)), std::memory_order_release);
+
+	return id;
+}
+Username_Interner::Id Username_Interner::find(std::string_view username) const {
+	const std::shared_ptr<const Table> table = snapshot();
+	const auto itr = table->ids.find(username);
+
+	return itr == table->ids.end() ? invalid_id : itr->second;
+}
+std::string Username_Interner::name(Id id) const {
+	const std::shared_ptr<const Table> table = snapshot();
+
+	return id < table->names.size() ? *table->names[id] : std::string();
+}
+std::size_t Username_Interner::size() const {
+	return snapshot()->names.size();
+}
+
+std::shared_ptr<const Username_Interner::Table> Username_Interner::snapshot() const {
+	return std::atomic_load_explicit(&_table, std::memory_order_acquire);
+}
\ No newline at end of file
@@ -2,7 +2,9 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 void Utility::replace_string(std::string& target, const std::string& from, const std::string& to) {
     int start_pos = 0;
@@ -45,4 +47,27 @@ void Utility::discord_quote_formatting(std::string& string) {
 }
 std::string Utility::discord_timestamp_formatting(int64_t epoch_time) {
     return "<t:" + std::to_string(epoch_time) + ">";
+}
+uint64_t Utility::fnv1a_hash(std::string_view data, uint64_t seed) {
+    uint64_t hash = seed;
+    for(const char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+bool Utility::iequals(std::string_view lhs, std::string_view rhs) {
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char l, char r) {
+        return std::tolower(static_cast<unsigned char>(l)) == std::tolower(static_cast<unsigned char>(r));
+    });
+}
+uint64_t Utility::fnv1a_hash_folded(std::string_view data, uint64_t seed) {
+    uint64_t hash = seed;
+    for(const char c : data) {
+        hash ^= static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(c)));
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
 }
\ No newline at end of file